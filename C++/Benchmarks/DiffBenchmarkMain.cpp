@@ -0,0 +1,94 @@
+#include "utils/DiffBenchmark.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<uint64_t> sAllocations(0);
+
+    struct Config_s
+    {
+        const char* name;
+        Utils::DiffGenerator::TraversalMode mode;
+        bool snapshotHashes;
+        bool snapshotIndex;
+    };
+
+    const Config_s sConfigs[] =
+    {
+        { "two-pass", Utils::DiffGenerator::TraversalMode::TwoPass, false, false },
+        { "merged", Utils::DiffGenerator::TraversalMode::Merged, false, false },
+        { "merged+index", Utils::DiffGenerator::TraversalMode::Merged, false, true },
+        { "merged+hash+index", Utils::DiffGenerator::TraversalMode::Merged, true, true }
+    };
+
+    const size_t sWidths[] = { 8, 32, 128, 512, 2048 };
+}
+
+void* operator new(size_t size)
+{
+    sAllocations.fetch_add(1, std::memory_order_relaxed);
+
+    if (auto memory = std::malloc(size > 0 ? size : 1))
+    {
+        return memory;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+// Width scaling sweep: a root object and about four child objects whose width grows from
+// a few members to thousands, so linear FindMember scans and MemberIndex lookups can be
+// compared while the document grows only linearly. Usage: DiffBenchmark [iterations]
+int main(int argc, char** argv)
+{
+    const size_t iterations = argc > 1 ? static_cast<size_t>(std::atoi(argv[1])) : 20;
+
+    std::printf("%-20s %8s %12s %12s %12s %12s %12s\n", "config", "width", "generate/s", "total us", "diff us", "allocs", "nodes");
+
+    for (const auto width : sWidths)
+    {
+        for (const auto& config : sConfigs)
+        {
+            Utils::DiffBenchmark::Options_s options;
+            options.document.depth = 1;
+            options.document.width = width;
+            options.document.objectRatio = std::min(1.0, 4.0 / static_cast<double>(width));
+            options.iterations = iterations;
+            options.snapshotHashes = config.snapshotHashes;
+            options.snapshotIndex = config.snapshotIndex;
+            options.allocationCounter = &sAllocations;
+
+            const auto mode = config.mode;
+            const auto result = Utils::DiffBenchmark(options).run([mode](Utils::DiffGenerator& generator)
+            {
+                generator.setTraversalMode(mode);
+            });
+
+            std::printf("%-20s %8zu %12.1f %12.1f %12.1f %12.1f %12llu%s\n",
+                config.name,
+                width,
+                result.getGeneratesPerSecond(),
+                result.getAverageNanoseconds(Utils::DiffMetrics_s::Phase::Total) / 1000.0,
+                result.getAverageNanoseconds(Utils::DiffMetrics_s::Phase::Diff) / 1000.0,
+                result.getAllocationsPerGenerate(),
+                static_cast<unsigned long long>(result.iterations > 0 ? result.counters.nodesVisited / result.iterations : 0),
+                result.failures > 0 ? " FAILED" : "");
+        }
+    }
+
+    return 0;
+}
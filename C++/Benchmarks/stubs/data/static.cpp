@@ -0,0 +1,3 @@
+#include "data/static.h"
+
+input_value PeopleModel::sLastUserSnapshot;
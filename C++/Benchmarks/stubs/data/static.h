@@ -0,0 +1,13 @@
+#pragma once
+
+// Minimal stand-in for the game's data/static.h so the benchmark builds on its own.
+
+#include <rapidjson/document.h>
+#include <cassert>
+
+typedef rapidjson::GenericValue<rapidjson::UTF8<>, rapidjson::MemoryPoolAllocator<>> input_value;
+
+struct PeopleModel
+{
+    static input_value sLastUserSnapshot;
+};
@@ -0,0 +1,16 @@
+#pragma once
+
+// Minimal stand-in for the game's user/IUser.h: only the dump entry point the diff uses.
+
+#include "data/static.h"
+
+namespace Utils
+{
+    class IUser
+    {
+    public:
+        virtual void save(input_value& out, input_value::AllocatorType& allocator) = 0;
+
+        virtual ~IUser() = default;
+    };
+}
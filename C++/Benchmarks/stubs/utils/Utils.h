@@ -0,0 +1,7 @@
+#pragma once
+
+// Minimal stand-in for the game's utils/Utils.h.
+
+#include <cassert>
+
+#define CC_ASSERT(condition) assert(condition)
@@ -0,0 +1,323 @@
+#include "ArrayDiff.h"
+#include "utils/SubtreeHash.h"
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace Utils
+{
+    const char* const ArrayDiff::sPatchKey = "\0array";
+    const size_t ArrayDiff::sPatchKeyLength = 6;
+
+    namespace
+    {
+        const int64_t kNoSource = -1;
+
+        bool getElementId(const input_value& element, const std::string& idField, std::string& outId)
+        {
+            if (idField.empty() || !element.IsObject())
+            {
+                return false;
+            }
+
+            const auto id = element.FindMember(idField.c_str());
+
+            if (id == element.MemberEnd())
+            {
+                return false;
+            }
+
+            if (id->value.IsString())
+            {
+                outId.assign(id->value.GetString(), id->value.GetStringLength());
+                return true;
+            }
+
+            if (id->value.IsInt64())
+            {
+                outId = "#" + std::to_string(id->value.GetInt64());
+                return true;
+            }
+
+            return false;
+        }
+
+        const input_value* findMember(const input_value& object, const char* name)
+        {
+            const auto member = object.FindMember(name);
+            return member != object.MemberEnd() ? &member->value : nullptr;
+        }
+
+        void pushInt(input_value& array, int64_t value, input_value::AllocatorType& allocator)
+        {
+            input_value item;
+            item.SetInt64(value);
+            array.PushBack(item, allocator);
+        }
+    }
+
+    bool ArrayDiff::build(const input_value& curr, const input_value& prev, const Options_s& options,
+        input_value& outPatch, input_value::AllocatorType& allocator)
+    {
+        if (!options.enabled || !curr.IsArray() || !prev.IsArray() || curr.Size() < options.minLength)
+        {
+            return false;
+        }
+
+        std::unordered_map<std::string, int64_t> prevById;
+        std::unordered_multimap<uint64_t, int64_t> prevByHash;
+        std::string id;
+
+        for (rapidjson::SizeType i = 0; i < prev.Size(); i++)
+        {
+            if (getElementId(prev[i], options.idField, id))
+            {
+                prevById.emplace(id, i);
+            }
+            else
+            {
+                prevByHash.emplace(SubtreeHash::compute(prev[i]), i);
+            }
+        }
+
+        std::vector<int64_t> sources(curr.Size(), kNoSource);
+        size_t literals = 0;
+        auto lastSource = kNoSource;
+
+        for (rapidjson::SizeType i = 0; i < curr.Size(); i++)
+        {
+            const auto& element = curr[i];
+            auto source = kNoSource;
+
+            if (lastSource != kNoSource && lastSource + 1 < static_cast<int64_t>(prev.Size()) &&
+                prev[static_cast<rapidjson::SizeType>(lastSource + 1)] == element)
+            {
+                source = lastSource + 1;
+            }
+            else if (getElementId(element, options.idField, id))
+            {
+                const auto match = prevById.find(id);
+
+                if (match != prevById.end() && prev[static_cast<rapidjson::SizeType>(match->second)] == element)
+                {
+                    source = match->second;
+                }
+            }
+            else if (i < prev.Size() && prev[i] == element)
+            {
+                source = i;
+            }
+            else
+            {
+                const auto range = prevByHash.equal_range(SubtreeHash::compute(element));
+
+                for (auto candidate = range.first; candidate != range.second; ++candidate)
+                {
+                    if (prev[static_cast<rapidjson::SizeType>(candidate->second)] == element)
+                    {
+                        source = candidate->second;
+                        break;
+                    }
+                }
+            }
+
+            if (source == kNoSource)
+            {
+                literals++;
+            }
+
+            sources[i] = source;
+            lastSource = source;
+        }
+
+        if (literals == curr.Size())
+        {
+            return false;
+        }
+
+        input_value ops(rapidjson::kArrayType);
+        input_value values(rapidjson::kArrayType);
+
+        for (size_t i = 0; i < sources.size(); )
+        {
+            auto end = i + 1;
+
+            if (sources[i] == kNoSource)
+            {
+                while (end < sources.size() && sources[end] == kNoSource)
+                {
+                    end++;
+                }
+
+                pushInt(ops, -static_cast<int64_t>(end - i), allocator);
+
+                for (auto j = i; j < end; j++)
+                {
+                    input_value value(curr[static_cast<rapidjson::SizeType>(j)], allocator);
+                    values.PushBack(value, allocator);
+                }
+            }
+            else
+            {
+                while (end < sources.size() && sources[end] == sources[end - 1] + 1)
+                {
+                    end++;
+                }
+
+                pushInt(ops, sources[i], allocator);
+                pushInt(ops, static_cast<int64_t>(end - i), allocator);
+            }
+
+            i = end;
+        }
+
+        input_value body(rapidjson::kObjectType);
+        input_value length;
+        length.SetUint(curr.Size());
+        body.AddMember(rapidjson::StringRef("len"), length, allocator);
+        body.AddMember(rapidjson::StringRef("ops"), ops, allocator);
+        body.AddMember(rapidjson::StringRef("values"), values, allocator);
+
+        outPatch.SetObject();
+        outPatch.AddMember(rapidjson::StringRef(sPatchKey, sPatchKeyLength), body, allocator);
+        return true;
+    }
+
+    bool ArrayDiff::isPatch(const input_value& value)
+    {
+        if (!value.IsObject() || value.MemberCount() != 1)
+        {
+            return false;
+        }
+
+        const auto& name = value.MemberBegin()->name;
+        return name.GetStringLength() == sPatchKeyLength && std::memcmp(name.GetString(), sPatchKey, sPatchKeyLength) == 0;
+    }
+
+    bool ArrayDiff::apply(const input_value& patch, input_value& target, input_value::AllocatorType& allocator)
+    {
+        if (!isPatch(patch) || !target.IsArray())
+        {
+            return false;
+        }
+
+        const auto& body = patch.MemberBegin()->value;
+
+        if (!body.IsObject())
+        {
+            return false;
+        }
+
+        const auto ops = findMember(body, "ops");
+        const auto values = findMember(body, "values");
+        const auto length = findMember(body, "len");
+
+        if (ops == nullptr || !ops->IsArray() || values == nullptr || !values->IsArray() || length == nullptr || !length->IsUint())
+        {
+            return false;
+        }
+
+        // len comes from the wire: reserve no more than the inputs can produce and
+        // refuse to grow past it. Ops are validated before target is touched, and
+        // the first pass counts how often each target element is referenced.
+        const uint64_t resultLength = length->GetUint();
+        const uint64_t targetSize = target.Size();
+        const uint64_t valueCount = values->Size();
+        std::vector<uint8_t> uses(static_cast<size_t>(targetSize), 0);
+        uint64_t producedLength = 0;
+        uint64_t usedValues = 0;
+
+        for (rapidjson::SizeType i = 0; i < ops->Size(); i++)
+        {
+            if (!(*ops)[i].IsInt64())
+            {
+                return false;
+            }
+
+            const auto op = (*ops)[i].GetInt64();
+
+            if (op < 0)
+            {
+                const auto count = static_cast<uint64_t>(-(op + 1)) + 1;
+
+                if (count > valueCount - usedValues || count > resultLength - producedLength)
+                {
+                    return false;
+                }
+
+                usedValues += count;
+                producedLength += count;
+            }
+            else
+            {
+                if (++i >= ops->Size() || !(*ops)[i].IsInt64() || (*ops)[i].GetInt64() < 0)
+                {
+                    return false;
+                }
+
+                const auto start = static_cast<uint64_t>(op);
+                const auto count = static_cast<uint64_t>((*ops)[i].GetInt64());
+
+                if (start > targetSize || count > targetSize - start || count > resultLength - producedLength)
+                {
+                    return false;
+                }
+
+                for (uint64_t j = 0; j < count; j++)
+                {
+                    auto& use = uses[static_cast<size_t>(start + j)];
+                    use = use < 2 ? use + 1 : use;
+                }
+
+                producedLength += count;
+            }
+        }
+
+        if (producedLength != resultLength)
+        {
+            return false;
+        }
+
+        input_value result(rapidjson::kArrayType);
+        result.Reserve(static_cast<rapidjson::SizeType>(resultLength), allocator);
+        rapidjson::SizeType nextValue = 0;
+
+        for (rapidjson::SizeType i = 0; i < ops->Size(); i++)
+        {
+            const auto op = (*ops)[i].GetInt64();
+
+            if (op < 0)
+            {
+                const auto count = static_cast<uint64_t>(-(op + 1)) + 1;
+
+                for (uint64_t j = 0; j < count; j++)
+                {
+                    input_value value((*values)[nextValue++], allocator);
+                    result.PushBack(value, allocator);
+                }
+            }
+            else
+            {
+                const auto start = static_cast<rapidjson::SizeType>(op);
+                const auto count = static_cast<rapidjson::SizeType>((*ops)[++i].GetInt64());
+
+                for (auto j = start; j < start + count; j++)
+                {
+                    if (uses[j] == 1)
+                    {
+                        result.PushBack(target[j], allocator);
+                    }
+                    else
+                    {
+                        input_value value(target[j], allocator);
+                        result.PushBack(value, allocator);
+                    }
+                }
+            }
+        }
+
+        target.Swap(result);
+        return true;
+    }
+}
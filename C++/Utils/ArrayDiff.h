@@ -0,0 +1,32 @@
+#pragma once
+
+#include "data/static.h"
+#include <string>
+
+namespace Utils
+{
+    class ArrayDiff
+    {
+    public:
+        struct Options_s
+        {
+            bool enabled = false;
+            std::string idField;
+            size_t minLength = 16;
+        };
+
+        // A patch is an object whose only member is sPatchKey. The key starts with a NUL
+        // byte, so it cannot collide with member names produced by IUser::save; compare
+        // it with sPatchKeyLength, not as a C string. Changed elements are shipped whole
+        // as literals, not diffed recursively.
+        static const char* const sPatchKey;
+        static const size_t sPatchKeyLength;
+
+        static bool build(const input_value& curr, const input_value& prev, const Options_s& options,
+            input_value& outPatch, input_value::AllocatorType& allocator);
+
+        static bool isPatch(const input_value& value);
+        // Kept elements referenced by a single copy run are moved out of target, not copied.
+        static bool apply(const input_value& patch, input_value& target, input_value::AllocatorType& allocator);
+    };
+}
@@ -0,0 +1,514 @@
+#include "BinaryDiff.h"
+#include "utils/ArrayDiff.h"
+#include <string.h>
+
+namespace Utils
+{
+    void BinaryDiffWriter::clear()
+    {
+        mBuffer.clear();
+        mKeyIds.clear();
+        mPath.clear();
+        mEmittedDepth = 0;
+        mPendingLeaves = 0;
+    }
+
+    void BinaryDiffWriter::writeVarint(uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            mBuffer.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+
+        mBuffer.push_back(static_cast<uint8_t>(value));
+    }
+
+    void BinaryDiffWriter::writeKey(const char* key, size_t length)
+    {
+        const auto result = mKeyIds.emplace(std::string(key, length), static_cast<uint32_t>(mKeyIds.size()));
+
+        if (!result.second)
+        {
+            writeVarint(result.first->second + 1);
+            return;
+        }
+
+        writeVarint(0);
+        writeVarint(length);
+        mBuffer.insert(mBuffer.end(), key, key + length);
+    }
+
+    void BinaryDiffWriter::writeValue(const input_value& value)
+    {
+        switch (value.GetType())
+        {
+        case rapidjson::kNullType:
+        {
+            mBuffer.push_back(ValueType_Null);
+            break;
+        }
+        case rapidjson::kFalseType:
+        {
+            mBuffer.push_back(ValueType_False);
+            break;
+        }
+        case rapidjson::kTrueType:
+        {
+            mBuffer.push_back(ValueType_True);
+            break;
+        }
+        case rapidjson::kNumberType:
+        {
+            if (value.IsDouble())
+            {
+                const auto number = value.GetDouble();
+                uint64_t bits = 0;
+                memcpy(&bits, &number, sizeof(bits));
+                mBuffer.push_back(ValueType_Double);
+
+                for (auto i = 0; i < 8; i++)
+                {
+                    mBuffer.push_back(static_cast<uint8_t>(bits >> (i * 8)));
+                }
+            }
+            else if (value.IsInt64())
+            {
+                const auto number = value.GetInt64();
+                mBuffer.push_back(ValueType_Int);
+                writeVarint((static_cast<uint64_t>(number) << 1) ^ static_cast<uint64_t>(number >> 63));
+            }
+            else
+            {
+                mBuffer.push_back(ValueType_Uint);
+                writeVarint(value.GetUint64());
+            }
+
+            break;
+        }
+        case rapidjson::kStringType:
+        {
+            mBuffer.push_back(ValueType_String);
+            writeVarint(value.GetStringLength());
+            mBuffer.insert(mBuffer.end(), value.GetString(), value.GetString() + value.GetStringLength());
+            break;
+        }
+        case rapidjson::kArrayType:
+        {
+            mBuffer.push_back(ValueType_Array);
+            writeVarint(value.Size());
+
+            for (auto v = value.Begin(); v != value.End(); ++v)
+            {
+                writeValue(*v);
+            }
+
+            break;
+        }
+        case rapidjson::kObjectType:
+        {
+            mBuffer.push_back(ValueType_Object);
+            writeVarint(value.MemberCount());
+
+            for (auto m = value.MemberBegin(); m != value.MemberEnd(); ++m)
+            {
+                writeKey(m->name.GetString(), m->name.GetStringLength());
+                writeValue(m->value);
+            }
+
+            break;
+        }
+        }
+    }
+
+    void BinaryDiffWriter::syncPath()
+    {
+        if (mPendingLeaves > 0)
+        {
+            mBuffer.push_back(Op_Leave);
+            writeVarint(mPendingLeaves);
+            mPendingLeaves = 0;
+        }
+
+        for (; mEmittedDepth < mPath.size(); mEmittedDepth++)
+        {
+            mBuffer.push_back(Op_Enter);
+            writeKey(mPath[mEmittedDepth], strlen(mPath[mEmittedDepth]));
+        }
+    }
+
+    void BinaryDiffWriter::enter(const char* key)
+    {
+        mPath.push_back(key);
+    }
+
+    void BinaryDiffWriter::leave()
+    {
+        if (mEmittedDepth == mPath.size())
+        {
+            mEmittedDepth--;
+            mPendingLeaves++;
+        }
+
+        mPath.pop_back();
+    }
+
+    void BinaryDiffWriter::set(const input_value& value)
+    {
+        syncPath();
+        mBuffer.push_back(Op_Set);
+        writeValue(value);
+    }
+
+    void BinaryDiffWriter::remove()
+    {
+        syncPath();
+        mBuffer.push_back(Op_Delete);
+    }
+
+    void BinaryDiffWriter::patchArray(const input_value& patch)
+    {
+        syncPath();
+        mBuffer.push_back(Op_ArrayPatch);
+        writeValue(patch);
+    }
+
+    const std::vector<uint8_t>& BinaryDiffWriter::getBuffer() const
+    {
+        return mBuffer;
+    }
+
+    bool BinaryDiffApplier::Reader_s::readByte(uint8_t& outValue)
+    {
+        if (offset >= size)
+        {
+            return false;
+        }
+
+        outValue = data[offset++];
+        return true;
+    }
+
+    bool BinaryDiffApplier::Reader_s::readVarint(uint64_t& outValue)
+    {
+        outValue = 0;
+
+        for (auto shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t byte = 0;
+
+            if (!readByte(byte))
+            {
+                return false;
+            }
+
+            outValue |= static_cast<uint64_t>(byte & 0x7f) << shift;
+
+            if ((byte & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool BinaryDiffApplier::Reader_s::readKey(const std::string*& outKey)
+    {
+        uint64_t reference = 0;
+
+        if (!readVarint(reference))
+        {
+            return false;
+        }
+
+        if (reference > 0)
+        {
+            if (reference > keys.size())
+            {
+                return false;
+            }
+
+            outKey = &keys[reference - 1];
+            return true;
+        }
+
+        uint64_t length = 0;
+
+        if (!readVarint(length) || length > size - offset)
+        {
+            return false;
+        }
+
+        keys.emplace_back(reinterpret_cast<const char*>(data + offset), length);
+        offset += length;
+        outKey = &keys.back();
+        return true;
+    }
+
+    bool BinaryDiffApplier::readValue(Reader_s& reader, input_value& outValue, input_value::AllocatorType& allocator, size_t depth)
+    {
+        uint8_t type = 0;
+
+        if (depth > kMaxValueDepth || !reader.readByte(type))
+        {
+            return false;
+        }
+
+        switch (type)
+        {
+        case BinaryDiffWriter::ValueType_Null:
+        {
+            outValue.SetNull();
+            return true;
+        }
+        case BinaryDiffWriter::ValueType_False:
+        case BinaryDiffWriter::ValueType_True:
+        {
+            outValue.SetBool(type == BinaryDiffWriter::ValueType_True);
+            return true;
+        }
+        case BinaryDiffWriter::ValueType_Int:
+        {
+            uint64_t encoded = 0;
+
+            if (!reader.readVarint(encoded))
+            {
+                return false;
+            }
+
+            outValue.SetInt64(static_cast<int64_t>(encoded >> 1) ^ -static_cast<int64_t>(encoded & 1));
+            return true;
+        }
+        case BinaryDiffWriter::ValueType_Uint:
+        {
+            uint64_t number = 0;
+
+            if (!reader.readVarint(number))
+            {
+                return false;
+            }
+
+            outValue.SetUint64(number);
+            return true;
+        }
+        case BinaryDiffWriter::ValueType_Double:
+        {
+            uint64_t bits = 0;
+
+            for (auto i = 0; i < 8; i++)
+            {
+                uint8_t byte = 0;
+
+                if (!reader.readByte(byte))
+                {
+                    return false;
+                }
+
+                bits |= static_cast<uint64_t>(byte) << (i * 8);
+            }
+
+            double number = 0;
+            memcpy(&number, &bits, sizeof(number));
+            outValue.SetDouble(number);
+            return true;
+        }
+        case BinaryDiffWriter::ValueType_String:
+        {
+            uint64_t length = 0;
+
+            if (!reader.readVarint(length) || length > reader.size - reader.offset)
+            {
+                return false;
+            }
+
+            outValue.SetString(reinterpret_cast<const char*>(reader.data + reader.offset), static_cast<rapidjson::SizeType>(length), allocator);
+            reader.offset += length;
+            return true;
+        }
+        case BinaryDiffWriter::ValueType_Array:
+        {
+            uint64_t count = 0;
+
+            if (!reader.readVarint(count))
+            {
+                return false;
+            }
+
+            outValue.SetArray();
+
+            for (uint64_t i = 0; i < count; i++)
+            {
+                input_value item;
+
+                if (!readValue(reader, item, allocator, depth + 1))
+                {
+                    return false;
+                }
+
+                outValue.PushBack(item, allocator);
+            }
+
+            return true;
+        }
+        case BinaryDiffWriter::ValueType_Object:
+        {
+            uint64_t count = 0;
+
+            if (!reader.readVarint(count))
+            {
+                return false;
+            }
+
+            outValue.SetObject();
+
+            for (uint64_t i = 0; i < count; i++)
+            {
+                const std::string* key = nullptr;
+                input_value item;
+
+                if (!reader.readKey(key) || !readValue(reader, item, allocator, depth + 1))
+                {
+                    return false;
+                }
+
+                input_value name(key->c_str(), static_cast<rapidjson::SizeType>(key->size()), allocator);
+                outValue.AddMember(name, item, allocator);
+            }
+
+            return true;
+        }
+        default:
+        {
+            return false;
+        }
+        }
+    }
+
+    input_value* BinaryDiffApplier::materialize(std::vector<input_value*>& nodes, const std::vector<const std::string*>& keys, input_value::AllocatorType& allocator)
+    {
+        auto first = nodes.size();
+
+        while (nodes[first - 1] == nullptr)
+        {
+            first--;
+        }
+
+        for (auto i = first; i < nodes.size(); i++)
+        {
+            auto parent = nodes[i - 1];
+
+            if (!parent->IsObject())
+            {
+                parent->SetObject();
+            }
+
+            const auto key = keys[i - 1];
+            input_value name(key->c_str(), static_cast<rapidjson::SizeType>(key->size()), allocator);
+            input_value child(rapidjson::kObjectType);
+            parent->AddMember(name, child, allocator);
+            nodes[i] = &(parent->MemberEnd() - 1)->value;
+        }
+
+        return nodes.back();
+    }
+
+    bool BinaryDiffApplier::apply(const uint8_t* data, size_t size, input_value& target, input_value::AllocatorType& allocator)
+    {
+        Reader_s reader{ data, size, 0, {} };
+        // A null node is a path that does not exist in target yet. It is only created
+        // once a Set or ArrayPatch reaches it, so deletes of absent paths leave no trace.
+        std::vector<input_value*> nodes;
+        std::vector<const std::string*> keys;
+        nodes.push_back(&target);
+
+        uint8_t op = 0;
+
+        while (reader.readByte(op))
+        {
+            switch (op)
+            {
+            case BinaryDiffWriter::Op_Enter:
+            {
+                const std::string* key = nullptr;
+
+                if (!reader.readKey(key))
+                {
+                    return false;
+                }
+
+                const auto current = nodes.back();
+                input_value* child = nullptr;
+
+                if (current != nullptr && current->IsObject())
+                {
+                    const auto member = current->FindMember(key->c_str());
+
+                    if (member != current->MemberEnd())
+                    {
+                        child = &member->value;
+                    }
+                }
+
+                nodes.push_back(child);
+                keys.push_back(key);
+                break;
+            }
+            case BinaryDiffWriter::Op_Leave:
+            {
+                uint64_t count = 0;
+
+                if (!reader.readVarint(count) || count > keys.size())
+                {
+                    return false;
+                }
+
+                nodes.resize(nodes.size() - count);
+                keys.resize(keys.size() - count);
+                break;
+            }
+            case BinaryDiffWriter::Op_Set:
+            {
+                if (!readValue(reader, *materialize(nodes, keys, allocator), allocator))
+                {
+                    return false;
+                }
+
+                break;
+            }
+            case BinaryDiffWriter::Op_Delete:
+            {
+                if (keys.empty())
+                {
+                    return false;
+                }
+
+                if (nodes.back() != nullptr)
+                {
+                    nodes[nodes.size() - 2]->RemoveMember(keys.back()->c_str());
+                    nodes.back() = nullptr;
+                }
+                break;
+            }
+            case BinaryDiffWriter::Op_ArrayPatch:
+            {
+                input_value patch;
+
+                if (!readValue(reader, patch, allocator) ||
+                    !ArrayDiff::apply(patch, *materialize(nodes, keys, allocator), allocator))
+                {
+                    return false;
+                }
+
+                break;
+            }
+            default:
+            {
+                return false;
+            }
+            }
+        }
+
+        return true;
+    }
+}
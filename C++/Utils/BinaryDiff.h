@@ -0,0 +1,89 @@
+#pragma once
+
+#include "data/static.h"
+#include <stdint.h>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Utils
+{
+    class BinaryDiffWriter
+    {
+    public:
+        enum Op_e : uint8_t
+        {
+            Op_Enter = 1,
+            Op_Leave = 2,
+            Op_Set = 3,
+            Op_Delete = 4,
+            Op_ArrayPatch = 5
+        };
+
+        enum ValueType_e : uint8_t
+        {
+            ValueType_Null = 0,
+            ValueType_False = 1,
+            ValueType_True = 2,
+            ValueType_Int = 3,
+            ValueType_Uint = 4,
+            ValueType_Double = 5,
+            ValueType_String = 6,
+            ValueType_Array = 7,
+            ValueType_Object = 8
+        };
+
+    private:
+        std::vector<uint8_t> mBuffer;
+        std::unordered_map<std::string, uint32_t> mKeyIds;
+        std::vector<const char*> mPath;
+        size_t mEmittedDepth = 0;
+        size_t mPendingLeaves = 0;
+
+        void writeVarint(uint64_t value);
+        void writeKey(const char* key, size_t length);
+        void writeValue(const input_value& value);
+        void syncPath();
+
+    public:
+        BinaryDiffWriter() = default;
+
+        void clear();
+
+        void enter(const char* key);
+        void leave();
+
+        void set(const input_value& value);
+        void remove();
+        void patchArray(const input_value& patch);
+
+        const std::vector<uint8_t>& getBuffer() const;
+    };
+
+    class BinaryDiffApplier
+    {
+    private:
+        // Values nested deeper than this are rejected, so a malformed or hostile
+        // buffer cannot exhaust the stack through readValue recursion.
+        static const size_t kMaxValueDepth = 256;
+
+        struct Reader_s
+        {
+            const uint8_t* data;
+            size_t size;
+            size_t offset;
+            std::deque<std::string> keys;
+
+            bool readByte(uint8_t& outValue);
+            bool readVarint(uint64_t& outValue);
+            bool readKey(const std::string*& outKey);
+        };
+
+        static bool readValue(Reader_s& reader, input_value& outValue, input_value::AllocatorType& allocator, size_t depth = 0);
+        static input_value* materialize(std::vector<input_value*>& nodes, const std::vector<const std::string*>& keys, input_value::AllocatorType& allocator);
+
+    public:
+        static bool apply(const uint8_t* data, size_t size, input_value& target, input_value::AllocatorType& allocator);
+    };
+}
@@ -0,0 +1,217 @@
+#pragma once
+
+#include "utils/ObjectPool.h"
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+inline size_t getConcurrentPoolThreadIndex()
+{
+    static std::atomic<size_t> sNextIndex(0);
+    static thread_local size_t sIndex = sNextIndex.fetch_add(1, std::memory_order_relaxed);
+
+    return sIndex;
+}
+
+// Same newPooled/deletePooled API as ObjectPool, safe to share between threads.
+// Threads free into and allocate from one of kSlotCount spin-locked slots picked by
+// thread index. These are owned by the pool rather than thread_local, so no cache
+// outlives the pool; with more than kSlotCount threads some slots are shared. A slot
+// holding kMagazineCapacity items pushes them as one magazine onto a lock-free global
+// stack. A slot that runs dry takes the stack in one exchange, keeps one magazine and
+// pushes the rest back, so no free list is ever walked and no slot hoards magazines.
+// Objects freed on one thread are reused on another without taking the block mutex.
+template<typename T, class MemoryAllocator_t = DefaultMemoryAllocator>
+class ConcurrentObjectPool : private PoolBlockChain<MemoryAllocator_t>
+{
+private:
+    static const size_t kSlotCount = 64;
+    static const size_t kMagazineCapacity = 256;
+    static const size_t kRefillCount = 32;
+    static const size_t kCacheLineSize = 64;
+
+    typedef PoolBlockChain<MemoryAllocator_t> Chain_t;
+
+    // Overlaid on a free slot; nextMagazine is only used by the first item of a
+    // full magazine.
+    struct FreeItem_s
+    {
+        FreeItem_s* next;
+        FreeItem_s* nextMagazine;
+    };
+
+    struct alignas(kCacheLineSize) Slot_s
+    {
+        std::atomic_flag locked = ATOMIC_FLAG_INIT;
+        FreeItem_s* freeHead = nullptr;
+        size_t freeCount = 0;
+    };
+
+    class SlotLock
+    {
+    private:
+        Slot_s& mSlot;
+
+    public:
+        explicit SlotLock(Slot_s& slot) :
+            mSlot(slot)
+        {
+            while (mSlot.locked.test_and_set(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        ~SlotLock()
+        {
+            mSlot.locked.clear(std::memory_order_release);
+        }
+    };
+
+    Slot_s mSlots[kSlotCount];
+    std::atomic<FreeItem_s*> mGlobalMagazines;
+    std::mutex mNodeMutex;
+
+    static const size_t sItemSize;
+
+private:
+    ConcurrentObjectPool(const ConcurrentObjectPool<T, MemoryAllocator_t>& source) = delete;
+    void operator=(const ConcurrentObjectPool<T, MemoryAllocator_t>& source) = delete;
+
+    Slot_s& getSlot()
+    {
+        return mSlots[getConcurrentPoolThreadIndex() % kSlotCount];
+    }
+
+    void pushSlot(Slot_s& slot, void* item)
+    {
+        auto freeItem = static_cast<FreeItem_s*>(item);
+        freeItem->next = slot.freeHead;
+        slot.freeHead = freeItem;
+        slot.freeCount++;
+    }
+
+    T* popSlot(Slot_s& slot)
+    {
+        auto result = slot.freeHead;
+        slot.freeHead = result->next;
+        slot.freeCount--;
+
+        return reinterpret_cast<T*>(result);
+    }
+
+    // Pushes the magazines first..last, already linked through nextMagazine. Only
+    // pushes use compare-exchange; pops take the whole stack, so there is no ABA.
+    void pushMagazines(FreeItem_s* first, FreeItem_s* last)
+    {
+        auto head = mGlobalMagazines.load(std::memory_order_relaxed);
+
+        do
+        {
+            last->nextMagazine = head;
+        }
+        while (!mGlobalMagazines.compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    void flushSlot(Slot_s& slot)
+    {
+        pushMagazines(slot.freeHead, slot.freeHead);
+        slot.freeHead = nullptr;
+        slot.freeCount = 0;
+    }
+
+    bool refillFromMagazines(Slot_s& slot)
+    {
+        auto magazine = mGlobalMagazines.exchange(nullptr, std::memory_order_acquire);
+
+        if (magazine == nullptr)
+        {
+            return false;
+        }
+
+        if (auto rest = magazine->nextMagazine)
+        {
+            auto last = rest;
+
+            while (last->nextMagazine != nullptr)
+            {
+                last = last->nextMagazine;
+            }
+
+            pushMagazines(rest, last);
+        }
+
+        slot.freeHead = magazine;
+        slot.freeCount = kMagazineCapacity;
+        return true;
+    }
+
+    void refillFromBlocks(Slot_s& slot)
+    {
+        std::lock_guard<std::mutex> lock(mNodeMutex);
+
+        auto count = kRefillCount;
+        auto address = this->takeSlots(count);
+
+        for (size_t i = count; i > 0; i--)
+        {
+            pushSlot(slot, address + (i - 1) * sItemSize);
+        }
+    }
+
+    T* takeFree()
+    {
+        auto& slot = getSlot();
+        SlotLock lock(slot);
+
+        if (slot.freeHead == nullptr && !refillFromMagazines(slot))
+        {
+            refillFromBlocks(slot);
+        }
+
+        return popSlot(slot);
+    }
+
+public:
+    explicit ConcurrentObjectPool(size_t initialCapacity = 32, size_t maxBlockLength = 1000000) :
+        Chain_t(sItemSize, initialCapacity, maxBlockLength),
+        mGlobalMagazines(nullptr)
+    {
+    }
+
+    T* newPooled()
+    {
+        return new (takeFree()) T();
+    }
+
+    T* getNextNoConstruct()
+    {
+        return takeFree();
+    }
+
+    void deletePooled(T* content)
+    {
+        content->~T();
+        deleteWithoutDestroying(content);
+    }
+
+    void deleteWithoutDestroying(T* content)
+    {
+        auto& slot = getSlot();
+        SlotLock lock(slot);
+
+        if (slot.freeCount >= kMagazineCapacity)
+        {
+            flushSlot(slot);
+        }
+
+        pushSlot(slot, content);
+    }
+};
+
+template<typename T, class MemoryAllocator_t>
+const size_t ConcurrentObjectPool<T, MemoryAllocator_t>::sItemSize =
+    (((sizeof(T) > sizeof(FreeItem_s) ? sizeof(T) : sizeof(FreeItem_s)) + PoolAllocatorAlignment<MemoryAllocator_t>::value - 1) /
+    PoolAllocatorAlignment<MemoryAllocator_t>::value) * PoolAllocatorAlignment<MemoryAllocator_t>::value;
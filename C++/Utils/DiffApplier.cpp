@@ -0,0 +1,447 @@
+#include "DiffApplier.h"
+#include "utils/ArrayDiff.h"
+#include <algorithm>
+#include <functional>
+
+namespace Utils
+{
+    DiffApplier::DiffApplier(input_value* target, input_value::AllocatorType* allocator) :
+        mTarget(target),
+        mAllocator(allocator)
+    {
+        mRoot = newNode(KeyTable::kInvalidId);
+    }
+
+    DiffApplier::~DiffApplier()
+    {
+        mNodePool.releaseBatch(mNodes.data(), mNodes.size());
+    }
+
+    DiffApplier::OpNode_s* DiffApplier::newNode(uint32_t keyId)
+    {
+        auto node = mNodePool.newPooled();
+        node->id = static_cast<uint32_t>(mNodes.size());
+        node->keyId = keyId;
+
+        if (keyId != KeyTable::kInvalidId)
+        {
+            node->name = &mKeys.getName(keyId);
+        }
+
+        mNodes.push_back(node);
+        return node;
+    }
+
+    DiffApplier::OpNode_s* DiffApplier::findChild(const OpNode_s* parent, uint32_t keyId) const
+    {
+        const auto it = mChildIndex.find((static_cast<uint64_t>(parent->id) << 32) | keyId);
+        return it != mChildIndex.end() ? it->second : nullptr;
+    }
+
+    DiffApplier::OpNode_s* DiffApplier::getChild(OpNode_s* parent, const input_value& name)
+    {
+        const auto keyId = mKeys.intern(name.GetString(), name.GetStringLength());
+
+        if (keyId == KeyTable::kInvalidId)
+        {
+            mFailed = true;
+            return nullptr;
+        }
+
+        auto& child = mChildIndex[(static_cast<uint64_t>(parent->id) << 32) | keyId];
+
+        if (child == nullptr)
+        {
+            child = newNode(keyId);
+            parent->children.insertTail(child);
+            parent->childCount++;
+        }
+
+        return child;
+    }
+
+    void DiffApplier::discardChildren(OpNode_s* node)
+    {
+        node->children.clear();
+        node->childCount = 0;
+        node->patches.clear();
+    }
+
+    void DiffApplier::setValue(OpNode_s* node, const input_value* value)
+    {
+        discardChildren(node);
+        node->op = Op::Set;
+        node->value = value;
+    }
+
+    input_value& DiffApplier::makeOwned(OpNode_s* node)
+    {
+        if (node->value != &node->owned)
+        {
+            node->owned.CopyFrom(*node->value, mScratchAllocator);
+            node->value = &node->owned;
+        }
+
+        return node->owned;
+    }
+
+    void DiffApplier::foldDelete(OpNode_s* node, const input_value& diffDelete)
+    {
+        for (auto m = diffDelete.MemberBegin(); m != diffDelete.MemberEnd(); ++m)
+        {
+            auto child = getChild(node, m->name);
+
+            if (child == nullptr)
+            {
+                continue;
+            }
+
+            if (!m->value.IsObject())
+            {
+                discardChildren(child);
+                child->op = Op::Delete;
+                child->value = nullptr;
+                continue;
+            }
+
+            switch (child->op)
+            {
+            case Op::Descend:
+                foldDelete(child, m->value);
+                break;
+            case Op::Set:
+                applyDelete(makeOwned(child), m->value);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    void DiffApplier::foldModify(OpNode_s* node, const input_value& diffModify)
+    {
+        for (auto m = diffModify.MemberBegin(); m != diffModify.MemberEnd(); ++m)
+        {
+            auto child = getChild(node, m->name);
+            const auto& value = m->value;
+
+            if (child == nullptr)
+            {
+                continue;
+            }
+
+            if (ArrayDiff::isPatch(value))
+            {
+                switch (child->op)
+                {
+                case Op::Set:
+                    if (!ArrayDiff::apply(value, makeOwned(child), mScratchAllocator))
+                    {
+                        mFailed = true;
+                    }
+                    break;
+                case Op::PatchArray:
+                    child->patches.push_back(&value);
+                    break;
+                case Op::Descend:
+                    if (child->creates)
+                    {
+                        mFailed = true;
+                        break;
+                    }
+
+                    discardChildren(child);
+                    child->op = Op::PatchArray;
+                    child->patches.push_back(&value);
+                    break;
+                case Op::Delete:
+                    mFailed = true;
+                    break;
+                }
+            }
+            else if (value.IsObject() && value.MemberCount() > 0)
+            {
+                switch (child->op)
+                {
+                case Op::Descend:
+                    child->creates = true;
+                    foldModify(child, value);
+                    break;
+                case Op::Set:
+                    if (!applyModify(makeOwned(child), value, mScratchAllocator))
+                    {
+                        mFailed = true;
+                    }
+                    break;
+                default:
+                    setValue(child, &value);
+                    break;
+                }
+            }
+            else
+            {
+                setValue(child, &value);
+            }
+        }
+    }
+
+    void DiffApplier::resolveChildren(const input_value& target, OpNode_s* node) const
+    {
+        for (auto child = node->children.head(); child != nullptr; child = child->node.next)
+        {
+            child->match = -1;
+        }
+
+        if (node->childCount <= kScanThreshold)
+        {
+            for (auto child = node->children.head(); child != nullptr; child = child->node.next)
+            {
+                const auto member = target.FindMember(child->name->c_str());
+
+                if (member != target.MemberEnd())
+                {
+                    child->match = member - target.MemberBegin();
+                }
+            }
+
+            return;
+        }
+
+        int64_t index = 0;
+
+        for (auto m = target.MemberBegin(); m != target.MemberEnd(); ++m, ++index)
+        {
+            const auto keyId = mKeys.find(m->name.GetString(), m->name.GetStringLength());
+
+            if (keyId == KeyTable::kInvalidId)
+            {
+                continue;
+            }
+
+            const auto child = findChild(node, keyId);
+
+            if (child != nullptr && child->match < 0)
+            {
+                child->match = index;
+            }
+        }
+    }
+
+    bool DiffApplier::applyNode(input_value& target, OpNode_s* node)
+    {
+        if (!target.IsObject())
+        {
+            if (!node->creates)
+            {
+                return true;
+            }
+
+            target.SetObject();
+        }
+
+        resolveChildren(target, node);
+
+        auto result = true;
+        const auto eraseOffset = mEraseIndices.size();
+
+        for (auto child = node->children.head(); child != nullptr; child = child->node.next)
+        {
+            if (child->match < 0)
+            {
+                continue;
+            }
+
+            auto& value = (target.MemberBegin() + child->match)->value;
+
+            switch (child->op)
+            {
+            case Op::Descend:
+                result = applyNode(value, child) && result;
+                break;
+            case Op::Delete:
+                mEraseIndices.push_back(static_cast<rapidjson::SizeType>(child->match));
+                break;
+            case Op::Set:
+                value.CopyFrom(*child->value, *mAllocator);
+                break;
+            case Op::PatchArray:
+                for (const auto patch : child->patches)
+                {
+                    result = ArrayDiff::apply(*patch, value, *mAllocator) && result;
+                }
+                break;
+            }
+        }
+
+        std::sort(mEraseIndices.begin() + eraseOffset, mEraseIndices.end(), std::greater<rapidjson::SizeType>());
+
+        for (auto i = eraseOffset; i < mEraseIndices.size(); i++)
+        {
+            target.EraseMember(target.MemberBegin() + mEraseIndices[i]);
+        }
+
+        mEraseIndices.resize(eraseOffset);
+
+        for (auto child = node->children.head(); child != nullptr; child = child->node.next)
+        {
+            if (child->match >= 0 || child->op == Op::Delete || (child->op == Op::Descend && !child->creates))
+            {
+                continue;
+            }
+
+            if (child->op == Op::PatchArray)
+            {
+                result = false;
+                continue;
+            }
+
+            input_value name(child->name->c_str(), static_cast<rapidjson::SizeType>(child->name->size()), *mAllocator);
+            input_value value;
+
+            if (child->op == Op::Set)
+            {
+                value.CopyFrom(*child->value, *mAllocator);
+                target.AddMember(name, value, *mAllocator);
+            }
+            else
+            {
+                value.SetObject();
+                target.AddMember(name, value, *mAllocator);
+                result = applyNode((target.MemberEnd() - 1)->value, child) && result;
+            }
+        }
+
+        return result;
+    }
+
+    void DiffApplier::applyDelete(input_value& target, const input_value& diffDelete)
+    {
+        if (!target.IsObject())
+        {
+            return;
+        }
+
+        for (auto m = diffDelete.MemberBegin(); m != diffDelete.MemberEnd(); ++m)
+        {
+            const auto member = target.FindMember(m->name);
+
+            if (member == target.MemberEnd())
+            {
+                continue;
+            }
+
+            if (m->value.IsObject())
+            {
+                applyDelete(member->value, m->value);
+            }
+            else
+            {
+                target.EraseMember(member);
+            }
+        }
+    }
+
+    bool DiffApplier::applyModify(input_value& target, const input_value& diffModify, input_value::AllocatorType& allocator)
+    {
+        if (!target.IsObject())
+        {
+            target.SetObject();
+        }
+
+        auto result = true;
+
+        for (auto m = diffModify.MemberBegin(); m != diffModify.MemberEnd(); ++m)
+        {
+            const auto member = target.FindMember(m->name);
+
+            if (member == target.MemberEnd())
+            {
+                if (ArrayDiff::isPatch(m->value))
+                {
+                    result = false;
+                    continue;
+                }
+
+                input_value name(m->name.GetString(), m->name.GetStringLength(), allocator);
+                input_value value(m->value, allocator);
+                target.AddMember(name, value, allocator);
+            }
+            else if (ArrayDiff::isPatch(m->value))
+            {
+                result = ArrayDiff::apply(m->value, member->value, allocator) && result;
+            }
+            else if (m->value.IsObject() && m->value.MemberCount() > 0)
+            {
+                result = applyModify(member->value, m->value, allocator) && result;
+            }
+            else
+            {
+                member->value.CopyFrom(m->value, allocator);
+            }
+        }
+
+        return result;
+    }
+
+    void DiffApplier::add(const input_value& diffModify, const input_value& diffDelete)
+    {
+        if (diffDelete.IsObject())
+        {
+            foldDelete(mRoot, diffDelete);
+        }
+
+        if (diffModify.IsObject())
+        {
+            if (diffModify.MemberCount() > 0)
+            {
+                mRoot->creates = true;
+            }
+
+            foldModify(mRoot, diffModify);
+        }
+
+        mPendingCount++;
+    }
+
+    bool DiffApplier::flush()
+    {
+        if (mPendingCount == 0)
+        {
+            return true;
+        }
+
+        auto result = !mFailed && mTarget != nullptr && mAllocator != nullptr;
+
+        if (mTarget != nullptr && mAllocator != nullptr)
+        {
+            result = applyNode(*mTarget, mRoot) && result;
+        }
+
+        clear();
+        return result;
+    }
+
+    bool DiffApplier::apply(const input_value& diffModify, const input_value& diffDelete)
+    {
+        add(diffModify, diffDelete);
+        return flush();
+    }
+
+    void DiffApplier::clear()
+    {
+        mNodePool.releaseBatch(mNodes.data(), mNodes.size());
+        mNodes.clear();
+        mChildIndex.clear();
+        mKeys.clear();
+        mEraseIndices.clear();
+        mScratchAllocator.Clear();
+        mPendingCount = 0;
+        mFailed = false;
+        mRoot = newNode(KeyTable::kInvalidId);
+    }
+
+    size_t DiffApplier::getPendingCount() const
+    {
+        return mPendingCount;
+    }
+}
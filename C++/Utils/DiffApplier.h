@@ -0,0 +1,87 @@
+#pragma once
+
+#include "utils/IntrusiveList.h"
+#include "utils/KeyTable.h"
+#include "utils/ObjectPool.h"
+#include "data/static.h"
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Utils
+{
+    class DiffApplier
+    {
+    private:
+        enum class Op
+        {
+            Descend,
+            Delete,
+            Set,
+            PatchArray
+        };
+
+        struct OpNode_s
+        {
+            uint32_t id = 0;
+            uint32_t keyId = 0;
+            const std::string* name = nullptr;
+            Op op = Op::Descend;
+            bool creates = false;
+            const input_value* value = nullptr;
+            input_value owned;
+            std::vector<const input_value*> patches;
+            IntrusiveList<OpNode_s> children;
+            size_t childCount = 0;
+            int64_t match = -1;
+            IntrusiveListNode_s<OpNode_s> node;
+        };
+
+        static const size_t kScanThreshold = 8;
+
+        input_value* mTarget;
+        input_value::AllocatorType* mAllocator;
+        input_value::AllocatorType mScratchAllocator;
+        // Ids are scoped to the pending batch, so diff keys never reach the shared table.
+        KeyTable mKeys;
+        ObjectPool<OpNode_s> mNodePool;
+        std::vector<OpNode_s*> mNodes;
+        std::unordered_map<uint64_t, OpNode_s*> mChildIndex;
+        std::vector<rapidjson::SizeType> mEraseIndices;
+        OpNode_s* mRoot = nullptr;
+        size_t mPendingCount = 0;
+        bool mFailed = false;
+
+        DiffApplier(const DiffApplier& source) = delete;
+        void operator=(const DiffApplier& source) = delete;
+
+        OpNode_s* newNode(uint32_t keyId);
+        OpNode_s* getChild(OpNode_s* parent, const input_value& name);
+        OpNode_s* findChild(const OpNode_s* parent, uint32_t keyId) const;
+        void discardChildren(OpNode_s* node);
+        void setValue(OpNode_s* node, const input_value* value);
+        input_value& makeOwned(OpNode_s* node);
+
+        void foldDelete(OpNode_s* node, const input_value& diffDelete);
+        void foldModify(OpNode_s* node, const input_value& diffModify);
+
+        void resolveChildren(const input_value& target, OpNode_s* node) const;
+        bool applyNode(input_value& target, OpNode_s* node);
+
+        static void applyDelete(input_value& target, const input_value& diffDelete);
+        static bool applyModify(input_value& target, const input_value& diffModify, input_value::AllocatorType& allocator);
+
+    public:
+        DiffApplier(input_value* target, input_value::AllocatorType* allocator);
+        ~DiffApplier();
+
+        // The diffs are referenced, not copied, until the next flush().
+        void add(const input_value& diffModify, const input_value& diffDelete);
+        bool flush();
+        bool apply(const input_value& diffModify, const input_value& diffDelete);
+        void clear();
+
+        size_t getPendingCount() const;
+    };
+}
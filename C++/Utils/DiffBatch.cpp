@@ -0,0 +1,117 @@
+#include "DiffBatch.h"
+#include "utils/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+
+namespace Utils
+{
+    DiffBatch::Worker_s::Worker_s() :
+        generator(nullptr, &allocatorModify, &allocatorDelete)
+    {
+    }
+
+    DiffBatch::DiffBatch(ITaskExecutor* executor) :
+        mExecutor(executor)
+    {
+    }
+
+    void DiffBatch::setTraversalMode(DiffGenerator::TraversalMode mode)
+    {
+        mTraversalMode = mode;
+    }
+
+    void DiffBatch::setMetricsCallback(const DiffMetricsCallback_t& callback)
+    {
+        mMetricsCallback = callback;
+    }
+
+    void DiffBatch::clear()
+    {
+        mResults.clear();
+
+        for (auto& worker : mWorkers)
+        {
+            worker->allocatorModify.Clear();
+            worker->allocatorDelete.Clear();
+        }
+    }
+
+    bool DiffBatch::run(const Item_s* items, size_t count)
+    {
+        clear();
+        mResults.resize(count);
+
+        auto& executor = mExecutor != nullptr ? *mExecutor : ThreadPool::shared();
+        const auto workerCount = std::min(count, executor.getConcurrency() + 1);
+
+        while (mWorkers.size() < workerCount)
+        {
+            mWorkers.emplace_back(new Worker_s());
+        }
+
+        std::atomic<size_t> nextItem(0);
+
+        parallelFor(executor, workerCount, [&](size_t workerIndex)
+        {
+            auto& worker = *mWorkers[workerIndex];
+            worker.generator.setTraversalMode(mTraversalMode);
+            worker.generator.setExecutor(&executor);
+
+            for (auto index = nextItem++; index < count; index = nextItem++)
+            {
+                const auto& item = items[index];
+                auto& result = mResults[index];
+
+                result.diffModify.SetObject();
+                result.diffDelete.SetObject();
+
+                if (item.snapshot == nullptr)
+                {
+                    result.metrics.clear();
+                    result.result = false;
+                    continue;
+                }
+
+                worker.generator.setPlayer(item.player);
+                worker.generator.setSnapshot(item.snapshot);
+                worker.generator.setSnapshotHashes(item.snapshotHashes);
+                worker.generator.setSnapshotIndex(item.snapshotIndex);
+                worker.generator.setDirtyPaths(item.dirtyPaths);
+
+                result.result = worker.generator.generate(result.diffModify, result.diffDelete);
+                result.metrics = worker.generator.getLastMetrics();
+            }
+        });
+
+        mMetrics.clear();
+        mMetrics.result = true;
+
+        for (const auto& result : mResults)
+        {
+            mMetrics.add(result.metrics);
+            mMetrics.result = mMetrics.result && result.result;
+        }
+
+        if (mMetricsCallback)
+        {
+            mMetricsCallback(mMetrics);
+        }
+
+        return mMetrics.result;
+    }
+
+    size_t DiffBatch::getResultCount() const
+    {
+        return mResults.size();
+    }
+
+    const DiffBatch::Result_s& DiffBatch::getResult(size_t index) const
+    {
+        return mResults[index];
+    }
+
+    const DiffMetrics_s& DiffBatch::getLastMetrics() const
+    {
+        return mMetrics;
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "utils/DiffGenerator.h"
+#include <memory>
+#include <vector>
+
+namespace Utils
+{
+    class DiffBatch
+    {
+    public:
+        struct Item_s
+        {
+            IUser* player;
+            const input_value* snapshot;
+            const SubtreeHash* snapshotHashes;
+            const MemberIndex* snapshotIndex;
+            const DirtyPathTracker* dirtyPaths;
+        };
+
+        struct Result_s
+        {
+            input_value diffModify;
+            input_value diffDelete;
+            DiffMetrics_s metrics;
+            bool result = false;
+        };
+
+    private:
+        struct Worker_s
+        {
+            input_value::AllocatorType allocatorModify;
+            input_value::AllocatorType allocatorDelete;
+            DiffGenerator generator;
+
+            Worker_s();
+        };
+
+        std::vector<std::unique_ptr<Worker_s>> mWorkers;
+        std::vector<Result_s> mResults;
+        DiffMetrics_s mMetrics;
+        DiffMetricsCallback_t mMetricsCallback;
+        ITaskExecutor* mExecutor = nullptr;
+        DiffGenerator::TraversalMode mTraversalMode = DiffGenerator::TraversalMode::TwoPass;
+
+        DiffBatch(const DiffBatch& source) = delete;
+        void operator=(const DiffBatch& source) = delete;
+
+    public:
+        explicit DiffBatch(ITaskExecutor* executor = nullptr);
+
+        void setTraversalMode(DiffGenerator::TraversalMode mode);
+        // Called once per run() with the metrics of all items added together.
+        void setMetricsCallback(const DiffMetricsCallback_t& callback);
+
+        bool run(const Item_s* items, size_t count);
+        void clear();
+
+        size_t getResultCount() const;
+        const Result_s& getResult(size_t index) const;
+        const DiffMetrics_s& getLastMetrics() const;
+    };
+}
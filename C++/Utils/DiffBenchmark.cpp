@@ -0,0 +1,156 @@
+#include "DiffBenchmark.h"
+#include "utils/MemberIndex.h"
+#include "utils/SubtreeHash.h"
+#include "user/IUser.h"
+
+namespace Utils
+{
+    namespace
+    {
+        class SyntheticUser : public IUser
+        {
+        private:
+            const input_value& mDocument;
+
+        public:
+            explicit SyntheticUser(const input_value& document) :
+                mDocument(document)
+            {
+            }
+
+            void save(input_value& out, input_value::AllocatorType& allocator) override
+            {
+                out.CopyFrom(mDocument, allocator);
+            }
+        };
+    }
+
+    DiffBenchmark::DiffBenchmark(const Options_s& options) :
+        mOptions(options)
+    {
+    }
+
+    uint64_t DiffBenchmark::Result_s::getAverageNanoseconds(DiffMetrics_s::Phase phase) const
+    {
+        return iterations > 0 ? phaseNanoseconds[static_cast<size_t>(phase)] / iterations : 0;
+    }
+
+    double DiffBenchmark::Result_s::getGeneratesPerSecond() const
+    {
+        const auto total = phaseNanoseconds[static_cast<size_t>(DiffMetrics_s::Phase::Total)];
+        return total > 0 ? static_cast<double>(iterations) * 1e9 / static_cast<double>(total) : 0.0;
+    }
+
+    double DiffBenchmark::Result_s::getAllocationsPerGenerate() const
+    {
+        return iterations > 0 ? static_cast<double>(allocations) / static_cast<double>(iterations) : 0.0;
+    }
+
+    void DiffBenchmark::accumulate(Result_s& result, const DiffMetrics_s& metrics) const
+    {
+        result.iterations++;
+        result.counters.add(metrics.counters);
+        result.bytesDump += metrics.bytesDump;
+        result.bytesModify += metrics.bytesModify;
+        result.bytesDelete += metrics.bytesDelete;
+        result.bytesBinary += metrics.bytesBinary;
+
+        for (size_t i = 0; i < static_cast<size_t>(DiffMetrics_s::Phase::Count); i++)
+        {
+            result.phaseNanoseconds[i] += metrics.phaseNanoseconds[i];
+        }
+    }
+
+    DiffBenchmark::Result_s DiffBenchmark::run(const Setup_t& setup, const Iteration_t& iteration) const
+    {
+        Result_s result;
+        SyntheticDocument synthetic(mOptions.document);
+
+        input_value::AllocatorType documentAllocator;
+        input_value document;
+        synthetic.generate(document, documentAllocator);
+
+        input_value::AllocatorType snapshotAllocator;
+        input_value snapshot;
+        input_value::AllocatorType allocatorModify;
+        input_value::AllocatorType allocatorDelete;
+        DirtyPathTracker dirtyPaths;
+        SubtreeHash snapshotHashes;
+        MemberIndex snapshotIndex(mOptions.snapshotIndexMinWidth);
+        SyntheticUser user(document);
+
+        DiffGenerator generator(&user, &allocatorModify, &allocatorDelete);
+        generator.setSnapshot(&snapshot);
+
+        if (mOptions.snapshotHashes)
+        {
+            generator.setSnapshotHashes(&snapshotHashes);
+        }
+
+        if (mOptions.snapshotIndex)
+        {
+            generator.setSnapshotIndex(&snapshotIndex);
+        }
+
+        if (setup)
+        {
+            setup(generator);
+        }
+
+        if (mOptions.trackDirtyPaths)
+        {
+            generator.setDirtyPaths(&dirtyPaths);
+        }
+
+        const auto total = mOptions.warmupIterations + mOptions.iterations;
+
+        for (size_t i = 0; i < total; i++)
+        {
+            snapshot.SetNull();
+            snapshotAllocator.Clear();
+            snapshot.CopyFrom(document, snapshotAllocator);
+
+            if (mOptions.snapshotHashes)
+            {
+                snapshotHashes.build(snapshot);
+            }
+
+            if (mOptions.snapshotIndex)
+            {
+                snapshotIndex.build(snapshot);
+            }
+
+            if (iteration)
+            {
+                iteration(generator, snapshot);
+            }
+
+            dirtyPaths.clear();
+            const auto changes = synthetic.mutate(document, documentAllocator, mOptions.trackDirtyPaths ? &dirtyPaths : nullptr);
+
+            input_value diffModify(rapidjson::kObjectType);
+            input_value diffDelete(rapidjson::kObjectType);
+            allocatorModify.Clear();
+            allocatorDelete.Clear();
+
+            const auto allocations = mOptions.allocationCounter != nullptr ? mOptions.allocationCounter->load(std::memory_order_relaxed) : 0;
+            const auto succeeded = generator.generate(diffModify, diffDelete);
+
+            if (mOptions.allocationCounter != nullptr)
+            {
+                result.allocations += mOptions.allocationCounter->load(std::memory_order_relaxed) - allocations;
+            }
+
+            if (i < mOptions.warmupIterations)
+            {
+                continue;
+            }
+
+            result.changes += changes;
+            result.failures += succeeded ? 0 : 1;
+            accumulate(result, generator.getLastMetrics());
+        }
+
+        return result;
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "utils/DiffGenerator.h"
+#include "utils/DiffMetrics.h"
+#include "utils/SyntheticDocument.h"
+#include <atomic>
+#include <functional>
+
+namespace Utils
+{
+    class DiffBenchmark
+    {
+    public:
+        struct Options_s
+        {
+            SyntheticDocument::Options_s document;
+            size_t iterations = 100;
+            size_t warmupIterations = 5;
+            bool trackDirtyPaths = false;
+            // Rebuilt from the snapshot after every copy, so they never go stale.
+            bool snapshotHashes = false;
+            bool snapshotIndex = false;
+            size_t snapshotIndexMinWidth = 32;
+            // Incremented by the host's allocator; sampled around each generate().
+            const std::atomic<uint64_t>* allocationCounter = nullptr;
+        };
+
+        struct Result_s
+        {
+            size_t iterations = 0;
+            size_t changes = 0;
+            size_t failures = 0;
+            DiffCounters_s counters;
+            size_t bytesDump = 0;
+            size_t bytesModify = 0;
+            size_t bytesDelete = 0;
+            size_t bytesBinary = 0;
+            uint64_t allocations = 0;
+            uint64_t phaseNanoseconds[static_cast<size_t>(DiffMetrics_s::Phase::Count)] = {};
+
+            uint64_t getAverageNanoseconds(DiffMetrics_s::Phase phase) const;
+            double getGeneratesPerSecond() const;
+            double getAllocationsPerGenerate() const;
+        };
+
+        typedef std::function<void(DiffGenerator& generator)> Setup_t;
+        // Called after the snapshot is refreshed and before each generate(); state
+        // derived from the snapshot must be rebuilt here, not in Setup_t.
+        typedef std::function<void(DiffGenerator& generator, const input_value& snapshot)> Iteration_t;
+
+    private:
+        Options_s mOptions;
+
+        void accumulate(Result_s& result, const DiffMetrics_s& metrics) const;
+
+    public:
+        explicit DiffBenchmark(const Options_s& options);
+
+        Result_s run(const Setup_t& setup = Setup_t(), const Iteration_t& iteration = Iteration_t()) const;
+    };
+}
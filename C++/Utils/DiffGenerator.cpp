@@ -1,59 +1,174 @@
 #include "DiffGenerator.h"
 #include "utils/Utils.h"
 #include "user/IUser.h"
-#include "utils/IntrusiveList.h"
-#include "utils/ObjectPool.h"
-#include "data/PersistentNameCache.h"
-#include <future>
+#include "utils/KeyTable.h"
+#include "utils/ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <string.h>
 
 namespace Utils
 {   
-    DiffGenerator::Handler::Handler(const input_value* diffTarget) :
-        mDiffTarget(diffTarget)
+    DiffGenerator::PathStack::PathStack()
     {
+        mEntries.reserve(64);
+    }
+
+    void DiffGenerator::PathStack::clear()
+    {
+        mSize = 0;
+        mResolvedDepth = 0;
+
+        for (auto& depth : mOutputDepth)
+        {
+            depth = 0;
+        }
+    }
+
+    void DiffGenerator::PathStack::push(const char* name, const input_value* value, const MemberIndex* keyIndex)
+    {
+        if (mSize == mEntries.size())
+        {
+            mEntries.push_back(PathEntry_s{ name, value, nullptr, { nullptr, nullptr }, keyIndex, KeyTable::kInvalidId });
+        }
+        else
+        {
+            mEntries[mSize] = PathEntry_s{ name, value, nullptr, { nullptr, nullptr }, keyIndex, KeyTable::kInvalidId };
+        }
+
+        mSize++;
+    }
+
+    void DiffGenerator::PathStack::pop()
+    {
+        mSize--;
+
+        if (mResolvedDepth > mSize)
+        {
+            mResolvedDepth = mSize;
+        }
+
+        for (auto& depth : mOutputDepth)
+        {
+            if (depth > mSize)
+            {
+                depth = mSize;
+            }
+        }
+    }
+
+    bool DiffGenerator::PathStack::empty() const
+    {
+        return mSize == 0;
+    }
+
+    size_t DiffGenerator::PathStack::size() const
+    {
+        return mSize;
+    }
+
+    DiffGenerator::PathEntry_s* DiffGenerator::PathStack::data()
+    {
+        return mEntries.data();
+    }
+
+    DiffGenerator::PathEntry_s& DiffGenerator::PathStack::operator[](size_t depth)
+    {
+        return mEntries[depth];
+    }
+
+    size_t DiffGenerator::PathStack::getResolvedDepth() const
+    {
+        return mResolvedDepth;
+    }
+
+    void DiffGenerator::PathStack::setResolvedDepth(size_t depth)
+    {
+        mResolvedDepth = depth;
+    }
+
+    size_t DiffGenerator::PathStack::getOutputDepth(size_t output) const
+    {
+        return mOutputDepth[output];
+    }
+
+    void DiffGenerator::PathStack::setOutputDepth(size_t output, size_t depth)
+    {
+        mOutputDepth[output] = depth;
+    }
+
+    DiffGenerator::Handler::Handler(const input_value* diffTarget, PathStack& path) :
+        mDiffTarget(diffTarget),
+        mPath(path)
+    {
+        mPath.clear();
+    }
+
+    void DiffGenerator::Handler::setHashes(const SubtreeHash* sourceHashes, const SubtreeHash* targetHashes)
+    {
+        mSourceHashes = sourceHashes;
+        mTargetHashes = targetHashes;
+    }
+
+    void DiffGenerator::Handler::setIndexes(const MemberIndex* sourceIndex, const MemberIndex* targetIndex)
+    {
+        mSourceIndex = sourceIndex;
+        mTargetIndex = targetIndex;
+    }
+
+    void DiffGenerator::Handler::setBudget(OutputBudget* budget, const input_value::AllocatorType* allocator)
+    {
+        mMeter.attach(budget, allocator, nullptr);
+    }
+
+    DiffCounters_s& DiffGenerator::Handler::getCounters()
+    {
+        return mCounters;
     }
 
     const input_value* DiffGenerator::Handler::getCurrentElementFromTarget()
     {
-        if (mTargetPath.empty() || mDiffTarget == nullptr)
+        if (mPath.empty() || mDiffTarget == nullptr)
         {
             return nullptr;
         }
 
-        auto counter = 0U;
-        auto current = mDiffTarget;
-        auto pathEntry = mTargetPath.head();
+        auto depth = mPath.getResolvedDepth();
+        auto current = depth > 0 ? mPath[depth - 1].target : mDiffTarget;
+        mCounters.pathCacheHits += depth;
 
-        while (pathEntry != nullptr)
+        while (depth < mPath.size())
         {
-            auto& item = *pathEntry;
+            if (!current->IsObject())
+            {
+                return nullptr;
+            }
+
+            auto& item = mPath[depth];
+            const input_value::Member* currentMember = nullptr;
+            mCounters.pathCacheMisses++;
 
-            if (item.value != nullptr)
+            if (mTargetIndex != nullptr)
             {
-                current = item.value;
-                pathEntry = pathEntry->node.next;
-                counter++;
-                continue;
+                currentMember = mTargetIndex->find(*current, item.name);
             }
             else
             {
-                auto currentMember = current->FindMember(item.name);
+                auto member = current->FindMember(item.name);
+                currentMember = member != current->MemberEnd() ? &*member : nullptr;
+            }
 
-                if (currentMember != current->MemberEnd())
-                {
-                    current = &currentMember->value;
-                    item.value = current;
-                    pathEntry = pathEntry->node.next;
-                    counter++;
-                }
-                else
-                {
-                    break;
-                }
+            if (currentMember == nullptr)
+            {
+                return nullptr;
             }
+
+            current = &currentMember->value;
+            item.target = current;
+            mPath.setResolvedDepth(++depth);
         }
 
-        return counter == mTargetPathSize ? current : nullptr;
+        return current;
     }
 
     bool DiffGenerator::Handler::Value(const input_value& inValue)
@@ -83,29 +198,32 @@ namespace Utils
 
     bool DiffGenerator::Handler::KeyStart(const input_value& inValue, const char* str, const input_value& inChildValue, bool& skipMembers)
     {
-        mPath.insertTail(new (mPathEntryPool.getNextNoConstruct()) PathEntry_s{ str, &inChildValue, nullptr });
-        mTargetPath.insertTail(new (mPathEntryPool.getNextNoConstruct()) PathEntry_s{ str, nullptr, nullptr });
-        mTargetPathSize++;
+        if (mMeter.isExceeded())
+        {
+            return false;
+        }
+
+        mCounters.nodesVisited++;
+        mPath.push(str, &inChildValue, mSourceIndex);
         return true;
     }
 
     bool DiffGenerator::Handler::KeyEnd(const input_value& inValue)
     {
-        mPathEntryPool.deletePooled(mPath.removeTail());
-        mPathEntryPool.deletePooled(mTargetPath.removeTail());
-        mTargetPathSize--;
+        mPath.pop();
         return true;
     }
 
-    DiffGenerator::DiffGenerator(User* player, input_value::AllocatorType* allocatoModify, input_value::AllocatorType* allocatorDelete) :
+    DiffGenerator::DiffGenerator(IUser* player, input_value::AllocatorType* allocatoModify, input_value::AllocatorType* allocatorDelete) :
         mPlayer(player),
+        mSnapshot(&PeopleModel::sLastUserSnapshot),
         mAllocatorModify(allocatoModify),
         mAllocatorDelete(allocatorDelete)
     {
     }
 
-    DiffGenerator::DeleteHandler::DeleteHandler(const input_value* target, input_value* outDiff, input_value::AllocatorType* allocator) :
-        Handler(target),
+    DiffGenerator::DeleteHandler::DeleteHandler(const input_value* target, PathStack& path, input_value* outDiff, input_value::AllocatorType* allocator) :
+        Handler(target, path),
         mOutDiff(outDiff),
         mOutDiffAllocator(allocator)
     {
@@ -113,31 +231,13 @@ namespace Utils
 
     void DiffGenerator::DeleteHandler::writeCurrentPathToDiff()
     {
-        auto current = mOutDiff;
-        auto pathEntry = mPath.head();
-
-        while (pathEntry != nullptr)
-        {
-            auto& item = *pathEntry;
-            auto currentMember = current->FindMember(item.name);
-
-            if (currentMember == current->MemberEnd())
-            {
-                input_value newNode(rapidjson::kObjectType);
-                const auto& key = item.cachedKey ? *item.cachedKey : PersistentNameCache::fetchAdd(item.name);
-                item.cachedKey = &key;
-                current->AddMember(rapidjson::StringRef(key.c_str()), newNode, *mOutDiffAllocator);
-                current = &((*current)[item.name]);
-            }
-            else
-            {
-                current = &currentMember->value;
-            }
-
-            pathEntry = pathEntry->node.next;
-        }
+        materializePath(mPath, PathStack::kDeleteOutput, mOutDiff, *mOutDiffAllocator)->SetInt(0);
+    }
 
-        current->SetInt(0);
+    bool DiffGenerator::DeleteHandler::StartArray(const input_value& inValue, bool& skipMembers)
+    {
+        skipMembers = true;
+        return true;
     }
 
     bool DiffGenerator::DeleteHandler::KeyStart(const input_value& inValue, const char* str, const input_value& inChildValue, bool& skipMembers)
@@ -153,13 +253,19 @@ namespace Utils
         {
             writeCurrentPathToDiff();
             skipMembers = true;
+            return mMeter.update();
+        }
+        else if (inChildValue.IsObject() && SubtreeHash::isSame(mSourceHashes, inChildValue, mTargetHashes, targetMemeber))
+        {
+            skipMembers = true;
+            mCounters.subtreesSkipped++;
         }
 
         return true;
     }
 
-    DiffGenerator::ModifyHandler::ModifyHandler(const input_value* target, input_value* outDiff, input_value::AllocatorType* allocator) :
-        Handler(target),
+    DiffGenerator::ModifyHandler::ModifyHandler(const input_value* target, PathStack& path, input_value* outDiff, input_value::AllocatorType* allocator) :
+        Handler(target, path),
         mOutDiff(outDiff),
         mOutDiffAllocator(allocator)
     {
@@ -184,7 +290,7 @@ namespace Utils
             }
         }
 
-        return true;
+        return mMeter.update();
     }
 
     bool DiffGenerator::ModifyHandler::StartObject(const input_value& curr)
@@ -199,152 +305,1194 @@ namespace Utils
             }
         }
 
-        return true;
+        return mMeter.update();
     }
 
-    bool DiffGenerator::ModifyHandler::StartArray(const input_value& inValue, bool& skipMembers)
+    void DiffGenerator::ModifyHandler::setArrayDiff(const ArrayDiff::Options_s* arrayDiff)
     {
-        Value(inValue);
-        skipMembers = true;
-        return true;
+        mArrayDiff = arrayDiff;
     }
 
-    void DiffGenerator::ModifyHandler::writeCurrentPathToDiff(const input_value& toBeCloned)
+    bool DiffGenerator::ModifyHandler::StartArray(const input_value& inValue, bool& skipMembers)
     {
-        auto current = mOutDiff;
-        auto pathEntry = mPath.head();
+        skipMembers = true;
 
-        while (pathEntry != nullptr)
+        if (mArrayDiff != nullptr)
         {
-            auto& item = *pathEntry;
-            auto currentMember = current->FindMember(item.name);
+            auto prev = getCurrentElementFromTarget();
 
-            if (currentMember == current->MemberEnd())
-            {
-                input_value newNode(rapidjson::kObjectType);
-                const auto& key = item.cachedKey ? *item.cachedKey : PersistentNameCache::fetchAdd(item.name);
-                item.cachedKey = &key;
-                current->AddMember(rapidjson::StringRef(key.c_str()), newNode, *mOutDiffAllocator);
-                current = &((*current)[item.name]);
-            }
-            else
+            if (prev != nullptr && prev->IsArray())
             {
-                current = &currentMember->value;
-            }
+                if (inValue != *prev)
+                {
+                    input_value patch;
+
+                    if (ArrayDiff::build(inValue, *prev, *mArrayDiff, patch, *mOutDiffAllocator))
+                    {
+                        *materializePath(mPath, PathStack::kModifyOutput, mOutDiff, *mOutDiffAllocator) = patch;
+                    }
+                    else
+                    {
+                        writeCurrentPathToDiff(inValue);
+                    }
+                }
 
-            pathEntry = pathEntry->node.next;
+                return mMeter.update();
+            }
         }
 
-        current->CopyFrom(toBeCloned, *mOutDiffAllocator);
+        return Value(inValue);
     }
 
-    bool DiffGenerator::accept(const input_value& target, Handler& handler) const
+    bool DiffGenerator::ModifyHandler::KeyStart(const input_value& inValue, const char* str, const input_value& inChildValue, bool& skipMembers)
     {
-        switch (target.GetType())
+        if (!Handler::KeyStart(inValue, str, inChildValue, skipMembers))
         {
-        case rapidjson::kObjectType:
+            return false;
+        }
+
+        if (inChildValue.IsObject() && mSourceHashes != nullptr)
         {
-            if (!handler.StartObject(target))
+            if (SubtreeHash::isSame(mSourceHashes, inChildValue, mTargetHashes, getCurrentElementFromTarget()))
             {
-                return false;
+                skipMembers = true;
+                mCounters.subtreesSkipped++;
             }
+        }
 
-            for (auto m = target.MemberBegin(); m != target.MemberEnd(); ++m)
-            {
-                auto skipMembers = false;
+        return true;
+    }
 
-                if (!handler.KeyStart(target, m->name.GetString(), m->value, skipMembers))
-                {
-                    return false;
-                }
+    void DiffGenerator::ModifyHandler::writeCurrentPathToDiff(const input_value& toBeCloned)
+    {
+        materializePath(mPath, PathStack::kModifyOutput, mOutDiff, *mOutDiffAllocator)->CopyFrom(toBeCloned, *mOutDiffAllocator);
+    }
 
-                if (!skipMembers)
-                {
-                    if (!accept(m->value, handler))
-                    {
-                        return false;
-                    }
-                }
+    DiffGenerator::MergedHandler::MergedHandler(PathStack& path, input_value* outDiffModify, input_value::AllocatorType* allocatorModify,
+        input_value* outDiffDelete, input_value::AllocatorType* allocatorDelete) :
+        mOutDiffModify(outDiffModify),
+        mAllocatorModify(allocatorModify),
+        mOutDiffDelete(outDiffDelete),
+        mAllocatorDelete(allocatorDelete),
+        mPath(path)
+    {
+        mPath.clear();
+    }
 
-                if (!handler.KeyEnd(target))
-                {
-                    return false;
-                }
-            }
+    void DiffGenerator::MergedHandler::setHashes(const SubtreeHash* currentHashes, const SubtreeHash* previousHashes)
+    {
+        mCurrentHashes = currentHashes;
+        mPreviousHashes = previousHashes;
+    }
 
-            return handler.EndObject(target, target.MemberCount());
+    void DiffGenerator::MergedHandler::setIndexes(const MemberIndex* currentIndex, const MemberIndex* previousIndex)
+    {
+        mCurrentIndex = currentIndex;
+        mPreviousIndex = previousIndex;
+    }
+
+    void DiffGenerator::MergedHandler::setArrayDiff(const ArrayDiff::Options_s* arrayDiff)
+    {
+        mArrayDiff = arrayDiff;
+    }
+
+    void DiffGenerator::MergedHandler::setBinaryOutput(BinaryDiffWriter* binaryOutput)
+    {
+        mBinaryOutput = binaryOutput;
+    }
+
+    void DiffGenerator::MergedHandler::setBudget(OutputBudget* budget)
+    {
+        mMeter.attach(budget, mAllocatorModify, mAllocatorDelete, mBinaryOutput);
+    }
+
+    const DiffCounters_s& DiffGenerator::MergedHandler::getCounters() const
+    {
+        return mCounters;
+    }
+
+    const input_value::Member* DiffGenerator::MergedHandler::findMember(const MemberIndex* index, const input_value& parent, const char* name) const
+    {
+        if (index != nullptr)
+        {
+            return index->find(parent, name);
         }
-        case rapidjson::kArrayType:
+
+        auto member = parent.FindMember(name);
+        return member != parent.MemberEnd() ? &*member : nullptr;
+    }
+
+    void DiffGenerator::MergedHandler::pushKey(const char* name, const MemberIndex* keyIndex)
+    {
+        mPath.push(name, nullptr, keyIndex);
+
+        if (mBinaryOutput != nullptr)
         {
-            auto skipMembers = false;
+            mBinaryOutput->enter(name);
+        }
+    }
 
-            if (!handler.StartArray(target, skipMembers))
+    void DiffGenerator::MergedHandler::popKey()
+    {
+        mPath.pop();
+
+        if (mBinaryOutput != nullptr)
+        {
+            mBinaryOutput->leave();
+        }
+    }
+
+    void DiffGenerator::MergedHandler::writeModify(const input_value& toBeCloned, const DiffSchema::Node_s* schema)
+    {
+        if (mBinaryOutput != nullptr)
+        {
+            if (schema == nullptr || schema->isLeaf())
             {
-                return false;
+                mBinaryOutput->set(toBeCloned);
+                return;
             }
 
-            if (!skipMembers)
+            input_value filtered;
+            DiffSchema::copyFiltered(schema, toBeCloned, filtered, *mAllocatorModify);
+            mBinaryOutput->set(filtered);
+            return;
+        }
+
+        DiffSchema::copyFiltered(schema, toBeCloned, *materializePath(mPath, PathStack::kModifyOutput, mOutDiffModify, *mAllocatorModify), *mAllocatorModify);
+    }
+
+    void DiffGenerator::MergedHandler::writeModify(const input_value& curr, const input_value& prev, const ArrayDiff::Options_s* arrayDiff)
+    {
+        if (arrayDiff != nullptr && curr.IsArray() && prev.IsArray())
+        {
+            input_value patch;
+
+            if (ArrayDiff::build(curr, prev, *arrayDiff, patch, *mAllocatorModify))
             {
-                for (auto v = target.Begin(); v != target.End(); ++v)
+                if (mBinaryOutput != nullptr)
                 {
-                    if (!accept(*v, handler))
-                    {
-                        return false;
-                    }
+                    mBinaryOutput->patchArray(patch);
+                    return;
                 }
-            }
 
-            return handler.EndArray(target, target.Size());
-        }
-        default:
-        {
-            return handler.Value(target);
-        }
+                *materializePath(mPath, PathStack::kModifyOutput, mOutDiffModify, *mAllocatorModify) = patch;
+                return;
+            }
         }
+
+        writeModify(curr, nullptr);
     }
 
-    bool DiffGenerator::processModify(input_value& outDiff)
+    void DiffGenerator::MergedHandler::writeDelete()
     {
-        ScopedTimer timer("DiffGenerator: processModify");
-        ModifyHandler handler(&PeopleModel::sLastUserSnapshot, &outDiff, mAllocatorModify);
-        accept(mUserDump, handler);
-        return true;
+        if (mBinaryOutput != nullptr)
+        {
+            mBinaryOutput->remove();
+            return;
+        }
+
+        materializePath(mPath, PathStack::kDeleteOutput, mOutDiffDelete, *mAllocatorDelete)->SetInt(0);
     }
 
-    bool DiffGenerator::processDelete(input_value& outDiff)
+    const ArrayDiff::Options_s* DiffGenerator::MergedHandler::getArrayDiff(const DiffSchema::Node_s* schema) const
     {
-        ScopedTimer timer("DiffGenerator: processDelete");
-        DeleteHandler handler(&mUserDump, &outDiff, mAllocatorDelete);
-        accept(PeopleModel::sLastUserSnapshot, handler);
-        return true;
+        switch (DiffSchema::getRule(schema))
+        {
+        case DiffSchema::Rule::DeepDiff:
+            return &schema->rule.arrayDiff;
+        case DiffSchema::Rule::WholeReplace:
+            return nullptr;
+        default:
+            return mArrayDiff;
+        }
     }
 
-    bool DiffGenerator::generate(input_value& outDiffModify, input_value& outDiffDelete)
+    bool DiffGenerator::MergedHandler::diff(const input_value& curr, const input_value& prev, const DirtyPathTracker::Node_s* dirty, const DiffSchema::Node_s* schema)
     {
-        ScopedTimer timer("DiffGenerator: generate total");
+        mCounters.nodesVisited++;
 
-        if (mPlayer == nullptr ||
-            mAllocatorModify == nullptr ||
-            mAllocatorDelete == nullptr)
+        if (!curr.IsObject())
         {
-            return false;
+            if (prev.IsObject() && !diffDeletedMembers(nullptr, prev, dirty, schema))
+            {
+                return false;
+            }
+
+            if (!DiffSchema::isEqual(schema, curr, prev))
+            {
+                writeModify(curr, prev, getArrayDiff(schema));
+            }
+
+            return mMeter.update();
         }
 
+        if (!prev.IsObject())
         {
-            ScopedTimer timer("DiffGenerator: dump current user");
-            mPlayer->save(mUserDump, mUserDumpAllocator);
+            writeModify(curr, schema);
+            return mMeter.update();
         }
 
-        auto delResult = std::async(std::launch::async, [&]()
+        if (SubtreeHash::isSame(mCurrentHashes, curr, mPreviousHashes, &prev))
         {
-            return processDelete(outDiffDelete);
-        });
+            mCounters.subtreesSkipped++;
+            return true;
+        }
 
-        auto modResult = std::async(std::launch::async, [&]()
+        if (DiffSchema::getRule(schema) == DiffSchema::Rule::WholeReplace)
         {
-            return processModify(outDiffModify);
-        });
+            if (curr == prev)
+            {
+                return true;
+            }
+
+            if (!diffDeletedMembers(&curr, prev, dirty, schema))
+            {
+                return false;
+            }
+
+            writeModify(curr, schema);
+            return mMeter.update();
+        }
+
+        for (auto m = curr.MemberBegin(); m != curr.MemberEnd(); ++m)
+        {
+            const DirtyPathTracker::Node_s* childDirty = nullptr;
+            const auto childSchema = DiffSchema::find(schema, m->name.GetString());
 
-        return delResult.get() && modResult.get();
+            if (!filterDirty(dirty, m->name.GetString(), childDirty) || DiffSchema::getRule(childSchema) == DiffSchema::Rule::Ignore)
+            {
+                mCounters.subtreesSkipped++;
+                continue;
+            }
+
+            if (mMeter.isExceeded())
+            {
+                return false;
+            }
+
+            pushKey(m->name.GetString(), mCurrentIndex);
+
+            const auto prevMember = findMember(mPreviousIndex, prev, m->name.GetString());
+            auto result = true;
+
+            if (prevMember == nullptr)
+            {
+                writeModify(m->value, childSchema);
+                result = mMeter.update();
+            }
+            else
+            {
+                result = diff(m->value, prevMember->value, childDirty, childSchema);
+            }
+
+            popKey();
+
+            if (!result)
+            {
+                return false;
+            }
+        }
+
+        return diffDeletedMembers(&curr, prev, dirty, schema);
+    }
+
+    bool DiffGenerator::MergedHandler::diffAt(const char* const* path, size_t length, const input_value* curr, const input_value* prev,
+        const DirtyPathTracker::Node_s* dirty, const DiffSchema::Node_s* schema)
+    {
+        for (size_t i = 0; i < length; i++)
+        {
+            // Split paths are built from current members, except the last key of a
+            // task for a deleted member, which comes from the previous document.
+            pushKey(path[i], curr == nullptr && i + 1 == length ? mPreviousIndex : mCurrentIndex);
+        }
+
+        auto result = true;
+
+        if (curr == nullptr)
+        {
+            mCounters.nodesVisited++;
+            writeDelete();
+            result = mMeter.update();
+        }
+        else if (prev == nullptr)
+        {
+            mCounters.nodesVisited++;
+            writeModify(*curr, schema);
+            result = mMeter.update();
+        }
+        else
+        {
+            result = diff(*curr, *prev, dirty, schema);
+        }
+
+        for (size_t i = 0; i < length; i++)
+        {
+            popKey();
+        }
+
+        return result;
+    }
+
+    bool DiffGenerator::MergedHandler::diffDeletedMembers(const input_value* curr, const input_value& prev, const DirtyPathTracker::Node_s* dirty, const DiffSchema::Node_s* schema)
+    {
+        for (auto m = prev.MemberBegin(); m != prev.MemberEnd(); ++m)
+        {
+            const DirtyPathTracker::Node_s* childDirty = nullptr;
+
+            if (!filterDirty(dirty, m->name.GetString(), childDirty) ||
+                DiffSchema::getRule(DiffSchema::find(schema, m->name.GetString())) == DiffSchema::Rule::Ignore)
+            {
+                continue;
+            }
+
+            if (curr == nullptr || findMember(mCurrentIndex, *curr, m->name.GetString()) == nullptr)
+            {
+                pushKey(m->name.GetString(), mPreviousIndex);
+                writeDelete();
+                popKey();
+
+                if (!mMeter.update())
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    input_value* DiffGenerator::materializePath(PathStack& path, size_t output, input_value* outDiff, input_value::AllocatorType& allocator)
+    {
+        auto& keyTable = KeyTable::instance();
+        auto depth = path.getOutputDepth(output);
+        auto current = depth > 0 ? path[depth - 1].outputs[output] : outDiff;
+
+        for (; depth < path.size(); depth++)
+        {
+            auto& item = path[depth];
+
+            if (!current->IsObject())
+            {
+                current->SetObject();
+            }
+
+            auto currentMember = current->FindMember(item.name);
+
+            if (currentMember == current->MemberEnd())
+            {
+                if (item.keyId == KeyTable::kInvalidId)
+                {
+                    item.keyId = item.keyIndex != nullptr ? item.keyIndex->getKeyId(item.name) : keyTable.intern(item.name);
+                }
+
+                input_value name;
+                input_value newNode(rapidjson::kObjectType);
+
+                if (item.keyId != KeyTable::kInvalidId)
+                {
+                    const auto& key = keyTable.getName(item.keyId);
+                    name.SetString(rapidjson::StringRef(key.c_str(), key.size()));
+                }
+                else
+                {
+                    name.SetString(item.name, static_cast<rapidjson::SizeType>(strlen(item.name)), allocator);
+                }
+
+                current->AddMember(name, newNode, allocator);
+                current = &(current->MemberEnd() - 1)->value;
+            }
+            else
+            {
+                current = &currentMember->value;
+            }
+
+            item.outputs[output] = current;
+            path.setOutputDepth(output, depth + 1);
+        }
+
+        return current;
+    }
+
+    bool DiffGenerator::filterDirty(const DirtyPathTracker::Node_s* dirty, const char* name, const DirtyPathTracker::Node_s*& outChildDirty)
+    {
+        outChildDirty = nullptr;
+
+        if (dirty == nullptr)
+        {
+            return true;
+        }
+
+        outChildDirty = dirty->find(name);
+
+        if (outChildDirty == nullptr)
+        {
+            return false;
+        }
+
+        if (outChildDirty->wholeSubtree)
+        {
+            outChildDirty = nullptr;
+        }
+
+        return true;
+    }
+
+    const DirtyPathTracker::Node_s* DiffGenerator::getDirtyRoot() const
+    {
+        if (mDirtyPaths == nullptr || mDirtyPaths->root()->wholeSubtree)
+        {
+            return nullptr;
+        }
+
+        return mDirtyPaths->root();
+    }
+
+    const DiffSchema::Node_s* DiffGenerator::getSchemaRoot() const
+    {
+        return mSchema != nullptr ? mSchema->root() : nullptr;
+    }
+
+    const ArrayDiff::Options_s* DiffGenerator::getArrayDiffOptions() const
+    {
+        return mArrayDiffOptions.enabled ? &mArrayDiffOptions : nullptr;
+    }
+
+    bool DiffGenerator::accept(const input_value& target, Handler& handler, const DirtyPathTracker::Node_s* dirty) const
+    {
+        switch (target.GetType())
+        {
+        case rapidjson::kObjectType:
+        {
+            if (!handler.StartObject(target))
+            {
+                return false;
+            }
+
+            for (auto m = target.MemberBegin(); m != target.MemberEnd(); ++m)
+            {
+                const DirtyPathTracker::Node_s* childDirty = nullptr;
+
+                if (!filterDirty(dirty, m->name.GetString(), childDirty))
+                {
+                    handler.getCounters().subtreesSkipped++;
+                    continue;
+                }
+
+                auto skipMembers = false;
+
+                if (!handler.KeyStart(target, m->name.GetString(), m->value, skipMembers))
+                {
+                    return false;
+                }
+
+                if (!skipMembers)
+                {
+                    if (!accept(m->value, handler, childDirty))
+                    {
+                        return false;
+                    }
+                }
+
+                if (!handler.KeyEnd(target))
+                {
+                    return false;
+                }
+            }
+
+            return handler.EndObject(target, target.MemberCount());
+        }
+        case rapidjson::kArrayType:
+        {
+            auto skipMembers = false;
+
+            if (!handler.StartArray(target, skipMembers))
+            {
+                return false;
+            }
+
+            if (!skipMembers)
+            {
+                for (auto v = target.Begin(); v != target.End(); ++v)
+                {
+                    if (!accept(*v, handler, nullptr))
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            return handler.EndArray(target, target.Size());
+        }
+        default:
+        {
+            return handler.Value(target);
+        }
+        }
+    }
+
+    bool DiffGenerator::processModify(input_value& outDiff, DiffCounters_s& outCounters)
+    {
+        PhaseTimer timer(mMetrics, DiffMetrics_s::Phase::Modify);
+        ModifyHandler handler(mSnapshot, mModifyPath, &outDiff, mAllocatorModify);
+        handler.setArrayDiff(getArrayDiffOptions());
+        handler.setBudget(getOutputBudget(), mAllocatorModify);
+
+        if (mSnapshotHashes != nullptr)
+        {
+            handler.setHashes(&mUserDumpHashes, mSnapshotHashes);
+        }
+
+        if (mSnapshotIndex != nullptr)
+        {
+            handler.setIndexes(&mUserDumpIndex, mSnapshotIndex);
+        }
+
+        const auto result = accept(mUserDump, handler, getDirtyRoot());
+        outCounters = handler.getCounters();
+        return result;
+    }
+
+    bool DiffGenerator::processDelete(input_value& outDiff, DiffCounters_s& outCounters)
+    {
+        PhaseTimer timer(mMetrics, DiffMetrics_s::Phase::Delete);
+        DeleteHandler handler(&mUserDump, mDeletePath, &outDiff, mAllocatorDelete);
+        handler.setBudget(getOutputBudget(), mAllocatorDelete);
+
+        if (mSnapshotHashes != nullptr)
+        {
+            handler.setHashes(mSnapshotHashes, &mUserDumpHashes);
+        }
+
+        if (mSnapshotIndex != nullptr)
+        {
+            handler.setIndexes(mSnapshotIndex, &mUserDumpIndex);
+        }
+
+        const auto result = accept(*mSnapshot, handler, getDirtyRoot());
+        outCounters = handler.getCounters();
+        return result;
+    }
+
+    void DiffGenerator::setDirtyPaths(const DirtyPathTracker* dirtyPaths)
+    {
+        mDirtyPaths = dirtyPaths;
+    }
+
+    void DiffGenerator::setPartialSaveSource(IPartialSaveSource* partialSaveSource)
+    {
+        mPartialSaveSource = partialSaveSource;
+    }
+
+    void DiffGenerator::setSnapshotHashes(const SubtreeHash* snapshotHashes)
+    {
+        mSnapshotHashes = snapshotHashes;
+    }
+
+    void DiffGenerator::setSnapshotIndex(const MemberIndex* snapshotIndex)
+    {
+        mSnapshotIndex = snapshotIndex;
+    }
+
+    bool DiffGenerator::processMerged(input_value& outDiffModify, input_value& outDiffDelete)
+    {
+        PhaseTimer timer(mMetrics, DiffMetrics_s::Phase::Diff);
+        MergedHandler handler(mModifyPath, &outDiffModify, mAllocatorModify, &outDiffDelete, mAllocatorDelete);
+        handler.setArrayDiff(getArrayDiffOptions());
+        handler.setBinaryOutput(mBinaryOutput);
+        handler.setBudget(getOutputBudget());
+
+        if (mSnapshotHashes != nullptr)
+        {
+            handler.setHashes(&mUserDumpHashes, mSnapshotHashes);
+        }
+
+        if (mSnapshotIndex != nullptr)
+        {
+            handler.setIndexes(&mUserDumpIndex, mSnapshotIndex);
+        }
+
+        const auto result = handler.diff(mUserDump, *mSnapshot, getDirtyRoot(), getSchemaRoot());
+        mMetrics.counters.add(handler.getCounters());
+        return result;
+    }
+
+    void DiffGenerator::addSplitTask(const std::vector<const char*>& path, const input_value* curr, const input_value* prev,
+        const DirtyPathTracker::Node_s* dirty, const DiffSchema::Node_s* schema)
+    {
+        mSplitTasks.push_back(SplitTask_s{ mSplitPaths.size(), path.size(), curr, prev, dirty, schema });
+        mSplitPaths.insert(mSplitPaths.end(), path.begin(), path.end());
+    }
+
+    void DiffGenerator::collectSplitTasks(const input_value& curr, const input_value& prev, const DirtyPathTracker::Node_s* dirty,
+        const DiffSchema::Node_s* schema, size_t depth, std::vector<const char*>& path)
+    {
+        if (SubtreeHash::isSame(&mUserDumpHashes, curr, mSnapshotHashes, &prev))
+        {
+            mMetrics.counters.subtreesSkipped++;
+            return;
+        }
+
+        const auto currentIndex = mSnapshotIndex != nullptr ? &mUserDumpIndex : nullptr;
+
+        for (auto m = curr.MemberBegin(); m != curr.MemberEnd(); ++m)
+        {
+            const DirtyPathTracker::Node_s* childDirty = nullptr;
+            const auto childSchema = DiffSchema::find(schema, m->name.GetString());
+
+            if (!filterDirty(dirty, m->name.GetString(), childDirty) || DiffSchema::getRule(childSchema) == DiffSchema::Rule::Ignore)
+            {
+                continue;
+            }
+
+            const input_value::Member* prevMember = nullptr;
+
+            if (mSnapshotIndex != nullptr)
+            {
+                prevMember = mSnapshotIndex->find(prev, m->name.GetString());
+            }
+            else
+            {
+                auto member = prev.FindMember(m->name.GetString());
+                prevMember = member != prev.MemberEnd() ? &*member : nullptr;
+            }
+
+            path.push_back(m->name.GetString());
+
+            if (depth > 1 && prevMember != nullptr && m->value.IsObject() && prevMember->value.IsObject() &&
+                DiffSchema::getRule(childSchema) != DiffSchema::Rule::WholeReplace)
+            {
+                collectSplitTasks(m->value, prevMember->value, childDirty, childSchema, depth - 1, path);
+            }
+            else
+            {
+                addSplitTask(path, &m->value, prevMember != nullptr ? &prevMember->value : nullptr, childDirty, childSchema);
+            }
+
+            path.pop_back();
+        }
+
+        for (auto m = prev.MemberBegin(); m != prev.MemberEnd(); ++m)
+        {
+            const DirtyPathTracker::Node_s* childDirty = nullptr;
+            const auto childSchema = DiffSchema::find(schema, m->name.GetString());
+
+            if (!filterDirty(dirty, m->name.GetString(), childDirty) || DiffSchema::getRule(childSchema) == DiffSchema::Rule::Ignore)
+            {
+                continue;
+            }
+
+            const auto found = currentIndex != nullptr ?
+                currentIndex->find(curr, m->name.GetString()) != nullptr :
+                curr.FindMember(m->name.GetString()) != curr.MemberEnd();
+
+            if (!found)
+            {
+                path.push_back(m->name.GetString());
+                addSplitTask(path, nullptr, &m->value, childDirty, childSchema);
+                path.pop_back();
+            }
+        }
+    }
+
+    void DiffGenerator::mergeDiff(input_value& target, input_value& source, input_value::AllocatorType& allocator)
+    {
+        for (auto m = source.MemberBegin(); m != source.MemberEnd(); ++m)
+        {
+            auto targetMember = target.FindMember(m->name);
+
+            if (targetMember != target.MemberEnd() && targetMember->value.IsObject() && m->value.IsObject())
+            {
+                mergeDiff(targetMember->value, m->value, allocator);
+            }
+            else
+            {
+                input_value value(m->value, allocator);
+                target.AddMember(rapidjson::StringRef(m->name.GetString(), m->name.GetStringLength()), value, allocator);
+            }
+        }
+    }
+
+    bool DiffGenerator::processParallel(input_value& outDiffModify, input_value& outDiffDelete)
+    {
+        if (!mUserDump.IsObject() || !mSnapshot->IsObject() || mUserDump.MemberCount() < mParallelMinMembers ||
+            DiffSchema::getRule(getSchemaRoot()) == DiffSchema::Rule::WholeReplace)
+        {
+            return processMerged(outDiffModify, outDiffDelete);
+        }
+
+        {
+            PhaseTimer timer(mMetrics, DiffMetrics_s::Phase::Collect);
+            std::vector<const char*> path;
+            mSplitTasks.clear();
+            mSplitPaths.clear();
+            collectSplitTasks(mUserDump, *mSnapshot, getDirtyRoot(), getSchemaRoot(), mParallelDepth, path);
+        }
+
+        return runSplitTasks(outDiffModify, outDiffDelete);
+    }
+
+    bool DiffGenerator::runSplitTasks(input_value& outDiffModify, input_value& outDiffDelete)
+    {
+        auto& executor = mExecutor != nullptr ? *mExecutor : ThreadPool::shared();
+        const auto workerCount = std::min(mSplitTasks.size(), executor.getConcurrency() + 1);
+
+        while (mSplitWorkers.size() < workerCount)
+        {
+            mSplitWorkers.emplace_back(new SplitWorker_s());
+        }
+
+        std::atomic<size_t> nextTask(0);
+        std::atomic<bool> allSucceeded(true);
+        mMetrics.splitTasks += mSplitTasks.size();
+
+        PhaseTimer diffTimer(mMetrics, DiffMetrics_s::Phase::Diff);
+        parallelFor(executor, workerCount, [&](size_t workerIndex)
+        {
+            auto& worker = *mSplitWorkers[workerIndex];
+            worker.diffModify.SetObject();
+            worker.diffDelete.SetObject();
+            worker.allocatorModify.Clear();
+            worker.allocatorDelete.Clear();
+
+            MergedHandler handler(worker.path, &worker.diffModify, &worker.allocatorModify, &worker.diffDelete, &worker.allocatorDelete);
+            handler.setArrayDiff(getArrayDiffOptions());
+            handler.setBudget(getOutputBudget());
+
+            if (mSnapshotHashes != nullptr && mSharedSnapshot == nullptr)
+            {
+                handler.setHashes(&mUserDumpHashes, mSnapshotHashes);
+            }
+
+            if (mSnapshotIndex != nullptr && mSharedSnapshot == nullptr)
+            {
+                handler.setIndexes(&mUserDumpIndex, mSnapshotIndex);
+            }
+
+            for (auto index = nextTask++; index < mSplitTasks.size(); index = nextTask++)
+            {
+                const auto& task = mSplitTasks[index];
+
+                if (!handler.diffAt(&mSplitPaths[task.pathOffset], task.pathLength, task.curr, task.prev, task.dirty, task.schema))
+                {
+                    allSucceeded = false;
+                    break;
+                }
+            }
+
+            worker.counters = handler.getCounters();
+        });
+
+        for (size_t i = 0; i < workerCount; i++)
+        {
+            mMetrics.counters.add(mSplitWorkers[i]->counters);
+        }
+
+        if (!allSucceeded)
+        {
+            return false;
+        }
+
+        {
+            PhaseTimer timer(mMetrics, DiffMetrics_s::Phase::Merge);
+
+            for (size_t i = 0; i < workerCount; i++)
+            {
+                mergeDiff(outDiffModify, mSplitWorkers[i]->diffModify, *mAllocatorModify);
+                mergeDiff(outDiffDelete, mSplitWorkers[i]->diffDelete, *mAllocatorDelete);
+            }
+        }
+
+        return allSucceeded;
+    }
+
+    bool DiffGenerator::processStreaming(input_value& outDiffModify, input_value& outDiffDelete)
+    {
+        PhaseTimer timer(mMetrics, DiffMetrics_s::Phase::Diff);
+        StreamingDiffHandler handler(mSnapshot, &outDiffModify, mAllocatorModify, &outDiffDelete, mAllocatorDelete);
+        handler.setSnapshotIndex(mSnapshotIndex);
+        handler.setArrayDiff(getArrayDiffOptions());
+        handler.setBudget(getOutputBudget());
+
+        const auto result = mStreamingSource->save(handler) && handler.isComplete();
+        mMetrics.counters.add(handler.getCounters());
+        return result;
+    }
+
+    void DiffGenerator::collectSharedTasks(const input_value& curr, const SharedSnapshot::Node_s& prev, const DirtyPathTracker::Node_s* dirty,
+        const DiffSchema::Node_s* schema, std::vector<const char*>& path)
+    {
+        if (!prev.isBranch)
+        {
+            addSplitTask(path, &curr, &prev.value, dirty, schema);
+            return;
+        }
+
+        const auto replace = DiffSchema::getRule(schema) == DiffSchema::Rule::WholeReplace;
+
+        if (replace && prev.equals(curr))
+        {
+            return;
+        }
+
+        if (curr.IsObject() && !replace)
+        {
+            for (auto m = curr.MemberBegin(); m != curr.MemberEnd(); ++m)
+            {
+                const DirtyPathTracker::Node_s* childDirty = nullptr;
+                const auto childSchema = DiffSchema::find(schema, m->name.GetString());
+
+                if (!filterDirty(dirty, m->name.GetString(), childDirty) || DiffSchema::getRule(childSchema) == DiffSchema::Rule::Ignore)
+                {
+                    continue;
+                }
+
+                const auto prevChild = prev.find(m->name.GetString());
+                path.push_back(m->name.GetString());
+
+                if (prevChild == nullptr)
+                {
+                    addSplitTask(path, &m->value, nullptr, childDirty, childSchema);
+                }
+                else
+                {
+                    collectSharedTasks(m->value, *prevChild, childDirty, childSchema, path);
+                }
+
+                path.pop_back();
+            }
+        }
+
+        for (const auto& chunk : prev.childChunks)
+        {
+            for (const auto& child : *chunk)
+            {
+                const DirtyPathTracker::Node_s* childDirty = nullptr;
+
+                if (!filterDirty(dirty, child.first.c_str(), childDirty) ||
+                    DiffSchema::getRule(DiffSchema::find(schema, child.first.c_str())) == DiffSchema::Rule::Ignore)
+                {
+                    continue;
+                }
+
+                if (!curr.IsObject() || curr.FindMember(child.first.c_str()) == curr.MemberEnd())
+                {
+                    path.push_back(child.first.c_str());
+                    addSplitTask(path, nullptr, nullptr, childDirty, nullptr);
+                    path.pop_back();
+                }
+            }
+        }
+
+        if (!curr.IsObject() || replace)
+        {
+            addSplitTask(path, &curr, nullptr, dirty, schema);
+        }
+    }
+
+    bool DiffGenerator::processShared(input_value& outDiffModify, input_value& outDiffDelete)
+    {
+        {
+            PhaseTimer timer(mMetrics, DiffMetrics_s::Phase::Collect);
+            std::vector<const char*> path;
+            mSplitTasks.clear();
+            mSplitPaths.clear();
+            collectSharedTasks(mUserDump, *mSharedSnapshot->root(), getDirtyRoot(), getSchemaRoot(), path);
+        }
+
+        if (mParallelDepth > 0 && mBinaryOutput == nullptr)
+        {
+            return runSplitTasks(outDiffModify, outDiffDelete);
+        }
+
+        PhaseTimer timer(mMetrics, DiffMetrics_s::Phase::Diff);
+        MergedHandler handler(mModifyPath, &outDiffModify, mAllocatorModify, &outDiffDelete, mAllocatorDelete);
+        handler.setArrayDiff(getArrayDiffOptions());
+        handler.setBinaryOutput(mBinaryOutput);
+        handler.setBudget(getOutputBudget());
+        mMetrics.splitTasks += mSplitTasks.size();
+
+        auto result = true;
+
+        for (const auto& task : mSplitTasks)
+        {
+            if (!handler.diffAt(&mSplitPaths[task.pathOffset], task.pathLength, task.curr, task.prev, task.dirty, task.schema))
+            {
+                result = false;
+                break;
+            }
+        }
+
+        mMetrics.counters.add(handler.getCounters());
+        return result;
+    }
+
+    void DiffGenerator::setTraversalMode(TraversalMode mode)
+    {
+        mTraversalMode = mode;
+    }
+
+    void DiffGenerator::setPlayer(IUser* player)
+    {
+        mPlayer = player;
+    }
+
+    void DiffGenerator::setSnapshot(const input_value* snapshot)
+    {
+        mSnapshot = snapshot;
+    }
+
+    void DiffGenerator::setExecutor(ITaskExecutor* executor)
+    {
+        mExecutor = executor;
+    }
+
+    void DiffGenerator::setParallelSplit(size_t depth, size_t minMembers)
+    {
+        mParallelDepth = depth;
+        mParallelMinMembers = minMembers;
+    }
+
+    void DiffGenerator::setArrayDiffOptions(const ArrayDiff::Options_s& options)
+    {
+        mArrayDiffOptions = options;
+    }
+
+    void DiffGenerator::setBinaryOutput(BinaryDiffWriter* binaryOutput)
+    {
+        mBinaryOutput = binaryOutput;
+    }
+
+    void DiffGenerator::setStreamingSource(IStreamingSource* streamingSource)
+    {
+        mStreamingSource = streamingSource;
+    }
+
+    void DiffGenerator::setSharedSnapshot(const SharedSnapshot* sharedSnapshot)
+    {
+        mSharedSnapshot = sharedSnapshot;
+    }
+
+    void DiffGenerator::setSchema(const DiffSchema* schema)
+    {
+        mSchema = schema;
+    }
+
+    const input_value& DiffGenerator::getUserDump() const
+    {
+        return mUserDump;
+    }
+
+    void DiffGenerator::setOutputBudget(size_t bytes)
+    {
+        mOutputBudgetBytes = bytes;
+    }
+
+    void DiffGenerator::setMetricsCallback(const DiffMetricsCallback_t& callback)
+    {
+        mMetricsCallback = callback;
+    }
+
+    const DiffMetrics_s& DiffGenerator::getLastMetrics() const
+    {
+        return mMetrics;
+    }
+
+    bool DiffGenerator::isFullSnapshotRequired() const
+    {
+        return mOutputBudget.isExceeded();
+    }
+
+    OutputBudget* DiffGenerator::getOutputBudget()
+    {
+        return mOutputBudgetBytes > 0 ? &mOutputBudget : nullptr;
+    }
+
+    bool DiffGenerator::rotateSharedSnapshot(const input_value& diffModify, const input_value& diffDelete, SharedSnapshot& outSnapshot) const
+    {
+        if (mSharedSnapshot == nullptr || mSharedSnapshot->empty() ||
+            mBinaryOutput != nullptr ||
+            mPartialDump ||
+            !mMetrics.result)
+        {
+            return false;
+        }
+
+        outSnapshot = mSharedSnapshot->rotate(mUserDump, diffModify, diffDelete);
+        return true;
+    }
+
+    bool DiffGenerator::generate(input_value& outDiffModify, input_value& outDiffDelete)
+    {
+        if ((mPlayer == nullptr && mStreamingSource == nullptr) ||
+            mSnapshot == nullptr ||
+            mAllocatorModify == nullptr ||
+            mAllocatorDelete == nullptr)
+        {
+            return false;
+        }
+
+        mMetrics.clear();
+        mOutputBudget.reset(mOutputBudgetBytes);
+        mPartialDump = false;
+
+        if (mBinaryOutput != nullptr)
+        {
+            mBinaryOutput->clear();
+        }
+
+        const auto modifySize = mAllocatorModify->Size();
+        const auto deleteSize = mAllocatorDelete->Size();
+        auto result = false;
+
+        {
+            PhaseTimer timer(mMetrics, DiffMetrics_s::Phase::Total);
+            result = process(outDiffModify, outDiffDelete);
+
+            if (!result && mOutputBudget.isExceeded())
+            {
+                outDiffModify.SetObject();
+                outDiffDelete.SetObject();
+
+                if (mBinaryOutput != nullptr)
+                {
+                    mBinaryOutput->clear();
+                }
+            }
+        }
+
+        mMetrics.result = result;
+        mMetrics.fullSnapshotRequired = mOutputBudget.isExceeded();
+        mMetrics.bytesModify = mAllocatorModify->Size() - modifySize;
+        mMetrics.bytesDelete = mAllocatorDelete != mAllocatorModify ? mAllocatorDelete->Size() - deleteSize : 0;
+        mMetrics.bytesBinary = mBinaryOutput != nullptr ? mBinaryOutput->getBuffer().size() : 0;
+
+        if (mMetricsCallback)
+        {
+            mMetricsCallback(mMetrics);
+        }
+
+        return result;
+    }
+
+    bool DiffGenerator::process(input_value& outDiffModify, input_value& outDiffDelete)
+    {
+        if ((mDirtyPaths != nullptr && mDirtyPaths->empty()) ||
+            DiffSchema::getRule(getSchemaRoot()) == DiffSchema::Rule::Ignore)
+        {
+            return true;
+        }
+
+        if (mStreamingSource != nullptr)
+        {
+            if (mBinaryOutput != nullptr || mSharedSnapshot != nullptr)
+            {
+                return false;
+            }
+
+            return processStreaming(outDiffModify, outDiffDelete);
+        }
+
+        {
+            PhaseTimer timer(mMetrics, DiffMetrics_s::Phase::Dump);
+            mUserDump.SetNull();
+            mUserDumpAllocator.Clear();
+
+            mPartialDump = mPartialSaveSource != nullptr && getDirtyRoot() != nullptr;
+
+            if (mPartialDump)
+            {
+                mPartialSaveSource->saveDirty(*mDirtyPaths, mUserDump, mUserDumpAllocator);
+            }
+            else
+            {
+                mPlayer->save(mUserDump, mUserDumpAllocator);
+            }
+
+            mMetrics.bytesDump = mUserDumpAllocator.Size();
+        }
+
+        if (mSharedSnapshot != nullptr && !mSharedSnapshot->empty())
+        {
+            return processShared(outDiffModify, outDiffDelete);
+        }
+
+        if (mSnapshotHashes != nullptr)
+        {
+            PhaseTimer timer(mMetrics, DiffMetrics_s::Phase::Hash);
+            mUserDumpHashes.build(mUserDump);
+
+            if (SubtreeHash::isSame(&mUserDumpHashes, mUserDump, mSnapshotHashes, mSnapshot))
+            {
+                mMetrics.counters.subtreesSkipped++;
+                return true;
+            }
+        }
+
+        if (mSnapshotIndex != nullptr)
+        {
+            PhaseTimer timer(mMetrics, DiffMetrics_s::Phase::Index);
+            mUserDumpIndex.setMinWidth(mSnapshotIndex->getMinWidth());
+            mUserDumpIndex.clear();
+        }
+
+        if (mBinaryOutput != nullptr)
+        {
+            return processMerged(outDiffModify, outDiffDelete);
+        }
+
+        if (mParallelDepth > 0)
+        {
+            return processParallel(outDiffModify, outDiffDelete);
+        }
+
+        if (mTraversalMode == TraversalMode::Merged || getSchemaRoot() != nullptr)
+        {
+            return processMerged(outDiffModify, outDiffDelete);
+        }
+
+        auto delResult = false;
+        auto modResult = false;
+        DiffCounters_s delCounters;
+        DiffCounters_s modCounters;
+        auto& executor = mExecutor != nullptr ? *mExecutor : ThreadPool::shared();
+
+        {
+            PhaseTimer timer(mMetrics, DiffMetrics_s::Phase::Diff);
+
+            parallelFor(executor, 2, [&](size_t index)
+            {
+                if (index == 0)
+                {
+                    delResult = processDelete(outDiffDelete, delCounters);
+                }
+                else
+                {
+                    modResult = processModify(outDiffModify, modCounters);
+                }
+            });
+        }
+
+        mMetrics.counters.add(delCounters);
+        mMetrics.counters.add(modCounters);
+        return delResult && modResult;
+    }
+
+    void DiffGenerator::generateBulk(BulkItem_s* items, size_t count, ITaskExecutor* executor)
+    {
+        auto& bulkExecutor = executor != nullptr ? *executor : ThreadPool::shared();
+
+        parallelFor(bulkExecutor, count, [items](size_t index)
+        {
+            auto& item = items[index];
+
+            if (item.snapshot == nullptr)
+            {
+                item.result = false;
+                return;
+            }
+
+            item.generator->setSnapshot(item.snapshot);
+            item.result = item.generator->generate(*item.outDiffModify, *item.outDiffDelete);
+        });
     }
 }
\ No newline at end of file
@@ -1,8 +1,20 @@
 #pragma once
 
-#include "utils/IntrusiveList.h"
-#include "utils/ObjectPool.h"
+#include "utils/DirtyPathTracker.h"
+#include "utils/SubtreeHash.h"
+#include "utils/MemberIndex.h"
+#include "utils/TaskExecutor.h"
+#include "utils/ArrayDiff.h"
+#include "utils/BinaryDiff.h"
+#include "utils/KeyTable.h"
+#include "utils/StreamingDiff.h"
+#include "utils/SharedSnapshot.h"
+#include "utils/OutputBudget.h"
+#include "utils/DiffMetrics.h"
+#include "utils/DiffSchema.h"
 #include "data/static.h"
+#include <memory>
+#include <vector>
 
 namespace Utils
 {
@@ -10,34 +22,114 @@ namespace Utils
 
     class DiffGenerator
     {
+    public:
+        enum class TraversalMode
+        {
+            TwoPass,
+            Merged
+        };
+
+        // Each item is diffed against its own snapshot, which must not be null.
+        struct BulkItem_s
+        {
+            DiffGenerator* generator;
+            const input_value* snapshot;
+            input_value* outDiffModify;
+            input_value* outDiffDelete;
+            bool result;
+        };
+
     private:
         struct PathEntry_s
         {
             const char* name;
             const input_value* value;
-            const std::string* cachedKey;
-            IntrusiveListNode_s<PathEntry_s> node;
+            const input_value* target;
+            input_value* outputs[2];
+            const MemberIndex* keyIndex;
+            uint32_t keyId;
+        };
+
+        class PathStack
+        {
+        public:
+            static const size_t kModifyOutput = 0;
+            static const size_t kDeleteOutput = 1;
+            static const size_t kOutputCount = 2;
+
+        private:
+            std::vector<PathEntry_s> mEntries;
+            size_t mSize = 0;
+            size_t mResolvedDepth = 0;
+            size_t mOutputDepth[kOutputCount] = {};
+
+        public:
+            PathStack();
+
+            void clear();
+            void push(const char* name, const input_value* value, const MemberIndex* keyIndex);
+            void pop();
+
+            bool empty() const;
+            size_t size() const;
+            PathEntry_s* data();
+            PathEntry_s& operator[](size_t depth);
+
+            size_t getResolvedDepth() const;
+            void setResolvedDepth(size_t depth);
+            size_t getOutputDepth(size_t output) const;
+            void setOutputDepth(size_t output, size_t depth);
         };
 
         IUser* mPlayer = nullptr;
+        const input_value* mSnapshot = nullptr;
+        ITaskExecutor* mExecutor = nullptr;
         input_value::AllocatorType* mAllocatorModify;
         input_value::AllocatorType* mAllocatorDelete;
         input_value::AllocatorType mUserDumpAllocator;
         input_value mUserDump;
+        const DirtyPathTracker* mDirtyPaths = nullptr;
+        const SubtreeHash* mSnapshotHashes = nullptr;
+        SubtreeHash mUserDumpHashes;
+        const MemberIndex* mSnapshotIndex = nullptr;
+        MemberIndex mUserDumpIndex;
+        TraversalMode mTraversalMode = TraversalMode::TwoPass;
+        size_t mParallelDepth = 0;
+        size_t mParallelMinMembers = 0;
+        ArrayDiff::Options_s mArrayDiffOptions;
+        BinaryDiffWriter* mBinaryOutput = nullptr;
+        IStreamingSource* mStreamingSource = nullptr;
+        IPartialSaveSource* mPartialSaveSource = nullptr;
+        const SharedSnapshot* mSharedSnapshot = nullptr;
+        bool mPartialDump = false;
+        const DiffSchema* mSchema = nullptr;
+        size_t mOutputBudgetBytes = 0;
+        OutputBudget mOutputBudget;
+        DiffMetrics_s mMetrics;
+        DiffMetricsCallback_t mMetricsCallback;
+        PathStack mModifyPath;
+        PathStack mDeletePath;
 
     private:
         class Handler
         {
         protected:
             const input_value* mDiffTarget = nullptr;
-            IntrusizeList<PathEntry_s> mPath;
-            IntrusizeList<PathEntry_s> mTargetPath;
-            ObjectPool<PathEntry_s> mPathEntryPool;
-            size_t mTargetPathSize = 0;
+            const SubtreeHash* mSourceHashes = nullptr;
+            const SubtreeHash* mTargetHashes = nullptr;
+            const MemberIndex* mSourceIndex = nullptr;
+            const MemberIndex* mTargetIndex = nullptr;
+            OutputMeter mMeter;
+            DiffCounters_s mCounters;
+            PathStack& mPath;
 
         public:
-            Handler(const input_value* diffTarget);
+            Handler(const input_value* diffTarget, PathStack& path);
 
+            void setHashes(const SubtreeHash* sourceHashes, const SubtreeHash* targetHashes);
+            void setIndexes(const MemberIndex* sourceIndex, const MemberIndex* targetIndex);
+            void setBudget(OutputBudget* budget, const input_value::AllocatorType* allocator);
+            DiffCounters_s& getCounters();
             const input_value* getCurrentElementFromTarget();
 
             virtual bool Value(const input_value& inValue);
@@ -58,9 +150,10 @@ namespace Utils
             input_value::AllocatorType* mOutDiffAllocator;
 
         public:
-            DeleteHandler(const input_value* target, input_value* outDiff, input_value::AllocatorType* allocator);
+            DeleteHandler(const input_value* target, PathStack& path, input_value* outDiff, input_value::AllocatorType* allocator);
             void writeCurrentPathToDiff();
 
+            bool StartArray(const input_value& inValue, bool& skipMembers) override;
             bool KeyStart(const input_value& inValue, const char* str, const input_value& inChildValue, bool& skipMembers) override;
         };
 
@@ -70,22 +163,148 @@ namespace Utils
             input_value* mOutDiff;
             input_value::AllocatorType* mOutDiffAllocator;
 
+            const ArrayDiff::Options_s* mArrayDiff = nullptr;
+
         public:
-            ModifyHandler(const input_value* target, input_value* outDiff, input_value::AllocatorType* allocator);
+            ModifyHandler(const input_value* target, PathStack& path, input_value* outDiff, input_value::AllocatorType* allocator);
+            void setArrayDiff(const ArrayDiff::Options_s* arrayDiff);
             void writeCurrentPathToDiff(const input_value& toBeCloned);
 
             bool Value(const input_value& curr) override;
             bool StartObject(const input_value& inValue) override;
             bool StartArray(const input_value& inValue, bool& skipMembers) override;
+            bool KeyStart(const input_value& inValue, const char* str, const input_value& inChildValue, bool& skipMembers) override;
         };
 
-        bool accept(const input_value& target, Handler& handler) const;
-        bool processModify(input_value& outDiff);
-        bool processDelete(input_value& outDiff);
+        class MergedHandler
+        {
+        protected:
+            input_value* mOutDiffModify;
+            input_value::AllocatorType* mAllocatorModify;
+            input_value* mOutDiffDelete;
+            input_value::AllocatorType* mAllocatorDelete;
+            const SubtreeHash* mCurrentHashes = nullptr;
+            const SubtreeHash* mPreviousHashes = nullptr;
+            const MemberIndex* mCurrentIndex = nullptr;
+            const MemberIndex* mPreviousIndex = nullptr;
+            const ArrayDiff::Options_s* mArrayDiff = nullptr;
+            BinaryDiffWriter* mBinaryOutput = nullptr;
+            OutputMeter mMeter;
+            DiffCounters_s mCounters;
+            PathStack& mPath;
+
+            const input_value::Member* findMember(const MemberIndex* index, const input_value& parent, const char* name) const;
+            void pushKey(const char* name, const MemberIndex* keyIndex);
+            void popKey();
+            void writeModify(const input_value& toBeCloned, const DiffSchema::Node_s* schema);
+            void writeModify(const input_value& curr, const input_value& prev, const ArrayDiff::Options_s* arrayDiff);
+            void writeDelete();
+            const ArrayDiff::Options_s* getArrayDiff(const DiffSchema::Node_s* schema) const;
+            bool diffDeletedMembers(const input_value* curr, const input_value& prev, const DirtyPathTracker::Node_s* dirty, const DiffSchema::Node_s* schema);
+
+        public:
+            MergedHandler(PathStack& path, input_value* outDiffModify, input_value::AllocatorType* allocatorModify,
+                input_value* outDiffDelete, input_value::AllocatorType* allocatorDelete);
+
+            void setHashes(const SubtreeHash* currentHashes, const SubtreeHash* previousHashes);
+            void setIndexes(const MemberIndex* currentIndex, const MemberIndex* previousIndex);
+            void setArrayDiff(const ArrayDiff::Options_s* arrayDiff);
+            void setBinaryOutput(BinaryDiffWriter* binaryOutput);
+            void setBudget(OutputBudget* budget);
+            const DiffCounters_s& getCounters() const;
+
+            bool diff(const input_value& curr, const input_value& prev, const DirtyPathTracker::Node_s* dirty, const DiffSchema::Node_s* schema);
+            bool diffAt(const char* const* path, size_t length, const input_value* curr, const input_value* prev,
+                const DirtyPathTracker::Node_s* dirty, const DiffSchema::Node_s* schema);
+        };
+
+        struct SplitTask_s
+        {
+            size_t pathOffset;
+            size_t pathLength;
+            const input_value* curr;
+            const input_value* prev;
+            const DirtyPathTracker::Node_s* dirty;
+            const DiffSchema::Node_s* schema;
+        };
+
+        struct SplitWorker_s
+        {
+            input_value::AllocatorType allocatorModify;
+            input_value::AllocatorType allocatorDelete;
+            input_value diffModify;
+            input_value diffDelete;
+            DiffCounters_s counters;
+            PathStack path;
+        };
+
+        std::vector<SplitTask_s> mSplitTasks;
+        std::vector<const char*> mSplitPaths;
+        std::vector<std::unique_ptr<SplitWorker_s>> mSplitWorkers;
+
+        static input_value* materializePath(PathStack& path, size_t output, input_value* outDiff, input_value::AllocatorType& allocator);
+        static bool filterDirty(const DirtyPathTracker::Node_s* dirty, const char* name, const DirtyPathTracker::Node_s*& outChildDirty);
+
+        bool accept(const input_value& target, Handler& handler, const DirtyPathTracker::Node_s* dirty) const;
+        const DirtyPathTracker::Node_s* getDirtyRoot() const;
+        const DiffSchema::Node_s* getSchemaRoot() const;
+        const ArrayDiff::Options_s* getArrayDiffOptions() const;
+        OutputBudget* getOutputBudget();
+        bool process(input_value& outDiffModify, input_value& outDiffDelete);
+        bool processModify(input_value& outDiff, DiffCounters_s& outCounters);
+        bool processDelete(input_value& outDiff, DiffCounters_s& outCounters);
+        bool processMerged(input_value& outDiffModify, input_value& outDiffDelete);
+        bool processParallel(input_value& outDiffModify, input_value& outDiffDelete);
+        bool processStreaming(input_value& outDiffModify, input_value& outDiffDelete);
+        bool processShared(input_value& outDiffModify, input_value& outDiffDelete);
+        bool runSplitTasks(input_value& outDiffModify, input_value& outDiffDelete);
+        void collectSplitTasks(const input_value& curr, const input_value& prev, const DirtyPathTracker::Node_s* dirty,
+            const DiffSchema::Node_s* schema, size_t depth, std::vector<const char*>& path);
+        void collectSharedTasks(const input_value& curr, const SharedSnapshot::Node_s& prev, const DirtyPathTracker::Node_s* dirty,
+            const DiffSchema::Node_s* schema, std::vector<const char*>& path);
+        void addSplitTask(const std::vector<const char*>& path, const input_value* curr, const input_value* prev,
+            const DirtyPathTracker::Node_s* dirty, const DiffSchema::Node_s* schema);
+        static void mergeDiff(input_value& target, input_value& source, input_value::AllocatorType& allocator);
 
     public:
         DiffGenerator(IUser* player, input_value::AllocatorType* allocatoModify, input_value::AllocatorType* allocatorDelete);
 
+        // Dirty paths restrict the traversal. The user is still dumped in full on every
+        // generate() unless a partial save source is set as well.
+        void setDirtyPaths(const DirtyPathTracker* dirtyPaths);
+        // Used instead of IUser::save whenever dirty paths are set and not everything
+        // is dirty. getUserDump() then only holds the dirty subtrees, so it must not
+        // be used to build or rotate the next snapshot.
+        void setPartialSaveSource(IPartialSaveSource* partialSaveSource);
+        void setSnapshotHashes(const SubtreeHash* snapshotHashes);
+        void setSnapshotIndex(const MemberIndex* snapshotIndex);
+        void setTraversalMode(TraversalMode mode);
+        void setPlayer(IUser* player);
+        void setSnapshot(const input_value* snapshot);
+        void setExecutor(ITaskExecutor* executor);
+        void setParallelSplit(size_t depth, size_t minMembers);
+        void setArrayDiffOptions(const ArrayDiff::Options_s& options);
+        void setBinaryOutput(BinaryDiffWriter* binaryOutput);
+        // The source is diffed straight against the snapshot document; snapshot hashes,
+        // dirty path filtering and the parallel split are not used. generate() returns
+        // false if binary output or a shared snapshot is set as well.
+        void setStreamingSource(IStreamingSource* streamingSource);
+        void setSharedSnapshot(const SharedSnapshot* sharedSnapshot);
+        // A schema forces the merged traversal; streaming sources are diffed without it.
+        void setSchema(const DiffSchema* schema);
+        void setOutputBudget(size_t bytes);
+        void setMetricsCallback(const DiffMetricsCallback_t& callback);
+
+        const input_value& getUserDump() const;
+        bool isFullSnapshotRequired() const;
+        const DiffMetrics_s& getLastMetrics() const;
+
         bool generate(input_value& outDiffModify, input_value& outDiffDelete);
+        // Rotates the shared snapshot to the last dump using the DOM diffs generate()
+        // just wrote. Returns false when they cannot describe the change: binary output
+        // leaves them empty, and a partial dump lacks the clean members.
+        bool rotateSharedSnapshot(const input_value& diffModify, const input_value& diffDelete, SharedSnapshot& outSnapshot) const;
+
+        static void generateBulk(BulkItem_s* items, size_t count, ITaskExecutor* executor = nullptr);
     };
 }
\ No newline at end of file
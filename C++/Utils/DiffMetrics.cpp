@@ -0,0 +1,70 @@
+#include "DiffMetrics.h"
+
+namespace Utils
+{
+    const char* const DiffMetrics_s::sPhaseNames[static_cast<size_t>(Phase::Count)] =
+    {
+        "dump",
+        "hash",
+        "index",
+        "collect",
+        "diff",
+        "modify",
+        "delete",
+        "merge",
+        "total"
+    };
+
+    void DiffCounters_s::add(const DiffCounters_s& other)
+    {
+        nodesVisited += other.nodesVisited;
+        subtreesSkipped += other.subtreesSkipped;
+        pathCacheHits += other.pathCacheHits;
+        pathCacheMisses += other.pathCacheMisses;
+    }
+
+    void DiffMetrics_s::clear()
+    {
+        *this = DiffMetrics_s();
+    }
+
+    void DiffMetrics_s::add(const DiffMetrics_s& other)
+    {
+        counters.add(other.counters);
+        bytesDump += other.bytesDump;
+        bytesModify += other.bytesModify;
+        bytesDelete += other.bytesDelete;
+        bytesBinary += other.bytesBinary;
+        splitTasks += other.splitTasks;
+
+        for (size_t i = 0; i < static_cast<size_t>(Phase::Count); i++)
+        {
+            phaseNanoseconds[i] += other.phaseNanoseconds[i];
+        }
+
+        fullSnapshotRequired = fullSnapshotRequired || other.fullSnapshotRequired;
+    }
+
+    uint64_t DiffMetrics_s::getPhaseNanoseconds(Phase phase) const
+    {
+        return phaseNanoseconds[static_cast<size_t>(phase)];
+    }
+
+    const char* DiffMetrics_s::getPhaseName(Phase phase)
+    {
+        return sPhaseNames[static_cast<size_t>(phase)];
+    }
+
+    PhaseTimer::PhaseTimer(DiffMetrics_s& metrics, DiffMetrics_s::Phase phase) :
+        mMetrics(metrics),
+        mPhase(phase),
+        mStart(std::chrono::steady_clock::now())
+    {
+    }
+
+    PhaseTimer::~PhaseTimer()
+    {
+        const auto elapsed = std::chrono::steady_clock::now() - mStart;
+        mMetrics.phaseNanoseconds[static_cast<size_t>(mPhase)] += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace Utils
+{
+    struct DiffCounters_s
+    {
+        uint64_t nodesVisited = 0;
+        uint64_t subtreesSkipped = 0;
+        uint64_t pathCacheHits = 0;
+        uint64_t pathCacheMisses = 0;
+
+        void add(const DiffCounters_s& other);
+    };
+
+    struct DiffMetrics_s
+    {
+        enum class Phase
+        {
+            Dump,
+            Hash,
+            Index,
+            Collect,
+            Diff,
+            Modify,
+            Delete,
+            Merge,
+            Total,
+            Count
+        };
+
+        static const char* const sPhaseNames[static_cast<size_t>(Phase::Count)];
+
+        DiffCounters_s counters;
+        size_t bytesDump = 0;
+        size_t bytesModify = 0;
+        size_t bytesDelete = 0;
+        size_t bytesBinary = 0;
+        size_t splitTasks = 0;
+        uint64_t phaseNanoseconds[static_cast<size_t>(Phase::Count)] = {};
+        bool result = false;
+        bool fullSnapshotRequired = false;
+
+        void clear();
+        void add(const DiffMetrics_s& other);
+        uint64_t getPhaseNanoseconds(Phase phase) const;
+        static const char* getPhaseName(Phase phase);
+    };
+
+    typedef std::function<void(const DiffMetrics_s& metrics)> DiffMetricsCallback_t;
+
+    class PhaseTimer
+    {
+    private:
+        DiffMetrics_s& mMetrics;
+        DiffMetrics_s::Phase mPhase;
+        std::chrono::steady_clock::time_point mStart;
+
+        PhaseTimer(const PhaseTimer& source) = delete;
+        void operator=(const PhaseTimer& source) = delete;
+
+    public:
+        PhaseTimer(DiffMetrics_s& metrics, DiffMetrics_s::Phase phase);
+        ~PhaseTimer();
+    };
+}
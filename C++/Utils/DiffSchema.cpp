@@ -0,0 +1,180 @@
+#include "DiffSchema.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+namespace Utils
+{
+    const char* const DiffSchema::sWildcard = "*";
+
+    namespace
+    {
+        bool childLess(const DiffSchema::Node_s::Child_t& child, const char* name)
+        {
+            return strcmp(child.first.c_str(), name) < 0;
+        }
+    }
+
+    const DiffSchema::Node_s* DiffSchema::Node_s::find(const char* name) const
+    {
+        if (!children.empty())
+        {
+            const auto it = std::lower_bound(children.begin(), children.end(), name, childLess);
+
+            if (it != children.end() && strcmp(it->first.c_str(), name) == 0)
+            {
+                return it->second.get();
+            }
+        }
+
+        return wildcard.get();
+    }
+
+    std::unique_ptr<DiffSchema::Node_s>& DiffSchema::Node_s::findOrAdd(const char* name)
+    {
+        auto it = std::lower_bound(children.begin(), children.end(), name, childLess);
+
+        if (it == children.end() || strcmp(it->first.c_str(), name) != 0)
+        {
+            it = children.emplace(it, std::string(name), std::unique_ptr<Node_s>());
+        }
+
+        return it->second;
+    }
+
+    bool DiffSchema::Node_s::isLeaf() const
+    {
+        return children.empty() && wildcard == nullptr;
+    }
+
+    void DiffSchema::add(const char* const* path, size_t length, const Rule_s& rule)
+    {
+        auto current = &mRoot;
+
+        for (size_t i = 0; i < length; i++)
+        {
+            std::unique_ptr<Node_s>* next = nullptr;
+
+            if (strcmp(path[i], sWildcard) == 0)
+            {
+                next = &current->wildcard;
+            }
+            else
+            {
+                next = &current->findOrAdd(path[i]);
+            }
+
+            if (*next == nullptr)
+            {
+                next->reset(new Node_s());
+            }
+
+            current = next->get();
+        }
+
+        current->rule = rule;
+
+        if (rule.type == Rule::DeepDiff)
+        {
+            current->rule.arrayDiff.enabled = true;
+        }
+    }
+
+    void DiffSchema::add(std::initializer_list<const char*> path, const Rule_s& rule)
+    {
+        add(path.begin(), path.size(), rule);
+    }
+
+    void DiffSchema::ignore(std::initializer_list<const char*> path)
+    {
+        Rule_s rule;
+        rule.type = Rule::Ignore;
+        add(path, rule);
+    }
+
+    void DiffSchema::floatEpsilon(std::initializer_list<const char*> path, double epsilon)
+    {
+        Rule_s rule;
+        rule.type = Rule::FloatEpsilon;
+        rule.epsilon = epsilon;
+        add(path, rule);
+    }
+
+    void DiffSchema::wholeReplace(std::initializer_list<const char*> path)
+    {
+        Rule_s rule;
+        rule.type = Rule::WholeReplace;
+        add(path, rule);
+    }
+
+    void DiffSchema::deepDiff(std::initializer_list<const char*> path, const ArrayDiff::Options_s& arrayDiff)
+    {
+        Rule_s rule;
+        rule.type = Rule::DeepDiff;
+        rule.arrayDiff = arrayDiff;
+        add(path, rule);
+    }
+
+    void DiffSchema::clear()
+    {
+        mRoot.rule = Rule_s();
+        mRoot.children.clear();
+        mRoot.wildcard.reset();
+    }
+
+    bool DiffSchema::empty() const
+    {
+        return mRoot.isLeaf() && mRoot.rule.type == Rule::Default;
+    }
+
+    const DiffSchema::Node_s* DiffSchema::root() const
+    {
+        return empty() ? nullptr : &mRoot;
+    }
+
+    const DiffSchema::Node_s* DiffSchema::find(const Node_s* node, const char* name)
+    {
+        return node != nullptr ? node->find(name) : nullptr;
+    }
+
+    DiffSchema::Rule DiffSchema::getRule(const Node_s* node)
+    {
+        return node != nullptr ? node->rule.type : Rule::Default;
+    }
+
+    bool DiffSchema::isEqual(const Node_s* node, const input_value& curr, const input_value& prev)
+    {
+        if (getRule(node) == Rule::FloatEpsilon && curr.IsNumber() && prev.IsNumber())
+        {
+            return fabs(curr.GetDouble() - prev.GetDouble()) <= node->rule.epsilon;
+        }
+
+        return curr == prev;
+    }
+
+    void DiffSchema::copyFiltered(const Node_s* node, const input_value& value, input_value& out, input_value::AllocatorType& allocator)
+    {
+        if (node == nullptr || node->isLeaf() || !value.IsObject())
+        {
+            out.CopyFrom(value, allocator);
+            return;
+        }
+
+        out.SetObject();
+
+        for (auto m = value.MemberBegin(); m != value.MemberEnd(); ++m)
+        {
+            const auto child = node->find(m->name.GetString());
+
+            if (getRule(child) == Rule::Ignore)
+            {
+                continue;
+            }
+
+            input_value name(m->name.GetString(), m->name.GetStringLength(), allocator);
+            input_value childValue;
+            copyFiltered(child, m->value, childValue, allocator);
+            out.AddMember(name, childValue, allocator);
+        }
+    }
+}
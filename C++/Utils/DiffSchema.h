@@ -0,0 +1,77 @@
+#pragma once
+
+#include "utils/ArrayDiff.h"
+#include "data/static.h"
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Utils
+{
+    class DiffSchema
+    {
+    public:
+        enum class Rule
+        {
+            Default,
+            DeepDiff,
+            Ignore,
+            FloatEpsilon,
+            WholeReplace
+        };
+
+        struct Rule_s
+        {
+            Rule type = Rule::Default;
+            double epsilon = 0.0;
+            ArrayDiff::Options_s arrayDiff;
+        };
+
+        struct Node_s
+        {
+            typedef std::pair<std::string, std::unique_ptr<Node_s>> Child_t;
+
+            Rule_s rule;
+            // Sorted by name, so lookups are a binary search with strcmp and take
+            // no lock or hash on the diff path.
+            std::vector<Child_t> children;
+            std::unique_ptr<Node_s> wildcard;
+
+            const Node_s* find(const char* name) const;
+            std::unique_ptr<Node_s>& findOrAdd(const char* name);
+            bool isLeaf() const;
+        };
+
+        static const char* const sWildcard;
+
+    private:
+        Node_s mRoot;
+
+    public:
+        DiffSchema() = default;
+
+        // Path elements equal to sWildcard match any member name at that level;
+        // an exact member name takes precedence over the wildcard. The exact child
+        // replaces the wildcard subtree rather than inheriting it: with {"*", "ts"}
+        // ignored and a rule added for {"inv", "x"}, "inv.ts" is no longer ignored
+        // unless {"inv", "ts"} is added as well.
+        void add(const char* const* path, size_t length, const Rule_s& rule);
+        void add(std::initializer_list<const char*> path, const Rule_s& rule);
+        void ignore(std::initializer_list<const char*> path);
+        void floatEpsilon(std::initializer_list<const char*> path, double epsilon);
+        void wholeReplace(std::initializer_list<const char*> path);
+        void deepDiff(std::initializer_list<const char*> path, const ArrayDiff::Options_s& arrayDiff = ArrayDiff::Options_s());
+        void clear();
+
+        bool empty() const;
+        const Node_s* root() const;
+
+        static const Node_s* find(const Node_s* node, const char* name);
+        static Rule getRule(const Node_s* node);
+        static bool isEqual(const Node_s* node, const input_value& curr, const input_value& prev);
+        // Copies value into out without the members node's rules ignore, at any depth.
+        static void copyFiltered(const Node_s* node, const input_value& value, input_value& out, input_value::AllocatorType& allocator);
+    };
+}
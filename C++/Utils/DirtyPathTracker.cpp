@@ -0,0 +1,71 @@
+#include "DirtyPathTracker.h"
+#include <string.h>
+
+namespace Utils
+{
+    const DirtyPathTracker::Node_s* DirtyPathTracker::Node_s::find(const char* childName) const
+    {
+        for (const auto& child : children)
+        {
+            if (strcmp(child->name.c_str(), childName) == 0)
+            {
+                return child.get();
+            }
+        }
+
+        return nullptr;
+    }
+
+    void DirtyPathTracker::markDirty(const char* const* path, size_t length)
+    {
+        auto current = &mRoot;
+
+        for (size_t i = 0; i < length; i++)
+        {
+            if (current->wholeSubtree)
+            {
+                return;
+            }
+
+            auto next = const_cast<Node_s*>(current->find(path[i]));
+
+            if (next == nullptr)
+            {
+                current->children.emplace_back(new Node_s());
+                next = current->children.back().get();
+                next->name = path[i];
+            }
+
+            current = next;
+        }
+
+        current->wholeSubtree = true;
+        current->children.clear();
+    }
+
+    void DirtyPathTracker::markDirty(std::initializer_list<const char*> path)
+    {
+        markDirty(path.begin(), path.size());
+    }
+
+    void DirtyPathTracker::markAllDirty()
+    {
+        markDirty(nullptr, 0);
+    }
+
+    void DirtyPathTracker::clear()
+    {
+        mRoot.wholeSubtree = false;
+        mRoot.children.clear();
+    }
+
+    bool DirtyPathTracker::empty() const
+    {
+        return !mRoot.wholeSubtree && mRoot.children.empty();
+    }
+
+    const DirtyPathTracker::Node_s* DirtyPathTracker::root() const
+    {
+        return &mRoot;
+    }
+}
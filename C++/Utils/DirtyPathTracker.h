@@ -0,0 +1,48 @@
+#pragma once
+
+#include "data/static.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include <initializer_list>
+
+namespace Utils
+{
+    class DirtyPathTracker
+    {
+    public:
+        struct Node_s
+        {
+            std::string name;
+            bool wholeSubtree = false;
+            std::vector<std::unique_ptr<Node_s>> children;
+
+            const Node_s* find(const char* childName) const;
+        };
+
+    private:
+        Node_s mRoot;
+
+    public:
+        DirtyPathTracker() = default;
+
+        void markDirty(const char* const* path, size_t length);
+        void markDirty(std::initializer_list<const char*> path);
+        void markAllDirty();
+        void clear();
+
+        bool empty() const;
+        const Node_s* root() const;
+    };
+
+    // Implemented by user models that can serialize only the dirty part of a user.
+    // out must contain every dirty path at its usual location, in full for paths
+    // marked as whole subtrees; members outside the dirty paths may be left out.
+    class IPartialSaveSource
+    {
+    public:
+        virtual void saveDirty(const DirtyPathTracker& dirtyPaths, input_value& out, input_value::AllocatorType& allocator) = 0;
+
+        virtual ~IPartialSaveSource() = default;
+    };
+}
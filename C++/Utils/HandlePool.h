@@ -0,0 +1,282 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// 32-bit reference into a HandlePool<T>: the low kIndexBits select a slot and the
+// rest hold the slot generation at the time of insertion. The zero value is never
+// issued, so a default constructed handle is always invalid.
+template<typename T>
+class Handle
+{
+public:
+	static const uint32_t kIndexBits = 20;
+	static const uint32_t kIndexMask = (1U << kIndexBits) - 1;
+	static const uint32_t kGenerationMask = (1U << (32 - kIndexBits)) - 1;
+
+private:
+	uint32_t mValue = 0;
+
+public:
+	Handle() = default;
+
+	Handle(uint32_t index, uint32_t generation) :
+		mValue((generation << kIndexBits) | index)
+	{
+	}
+
+	uint32_t getIndex() const
+	{
+		return mValue & kIndexMask;
+	}
+
+	uint32_t getGeneration() const
+	{
+		return mValue >> kIndexBits;
+	}
+
+	uint32_t getValue() const
+	{
+		return mValue;
+	}
+
+	bool isValid() const
+	{
+		return mValue != 0;
+	}
+
+	bool operator==(const Handle& other) const
+	{
+		return mValue == other.mValue;
+	}
+
+	bool operator!=(const Handle& other) const
+	{
+		return mValue != other.mValue;
+	}
+};
+
+// Slot map: objects live densely in insertion order (with swap-remove), so iterating
+// begin()..end() walks contiguous memory, while handles resolve through a slot table
+// in O(1). Removing an object bumps its slot generation, so stale handles resolve to
+// nullptr instead of aliasing whatever reuses the slot. A slot whose generation would
+// wrap is retired rather than reused.
+template<typename T>
+class HandlePool
+{
+public:
+	typedef Handle<T> Handle_t;
+	typedef typename std::vector<T>::iterator Iterator_t;
+	typedef typename std::vector<T>::const_iterator ConstIterator_t;
+
+private:
+	static const uint32_t kInvalidIndex = 0xffffffffU;
+
+	// denseIndex is kInvalidIndex while the slot is free; nextFree links free
+	// slots and is meaningless while the slot is live.
+	struct Slot_s
+	{
+		uint32_t denseIndex;
+		uint32_t generation;
+		uint32_t nextFree;
+	};
+
+	std::vector<T> mDense;
+	std::vector<uint32_t> mDenseToSlot;
+	std::vector<Slot_s> mSlots;
+	uint32_t mFirstFree = kInvalidIndex;
+
+	const Slot_s* findSlot(Handle_t handle) const
+	{
+		const auto index = handle.getIndex();
+
+		if (index >= mSlots.size())
+		{
+			return nullptr;
+		}
+
+		const auto& slot = mSlots[index];
+		return slot.generation == handle.getGeneration() && slot.denseIndex != kInvalidIndex ? &slot : nullptr;
+	}
+
+	template<typename Value_t>
+	static void reserveOneMore(std::vector<Value_t>& values)
+	{
+		if (values.size() == values.capacity())
+		{
+			values.reserve(values.empty() ? 1 : values.size() * 2);
+		}
+	}
+
+	// Must not throw: insert() reserves mSlots before the object is constructed.
+	uint32_t acquireSlot()
+	{
+		if (mFirstFree != kInvalidIndex)
+		{
+			const auto index = mFirstFree;
+			mFirstFree = mSlots[index].nextFree;
+			return index;
+		}
+
+		mSlots.push_back(Slot_s{ kInvalidIndex, 1, kInvalidIndex });
+		return static_cast<uint32_t>(mSlots.size() - 1);
+	}
+
+	void releaseSlot(uint32_t index)
+	{
+		auto& slot = mSlots[index];
+		slot.denseIndex = kInvalidIndex;
+		slot.generation = (slot.generation + 1) & Handle_t::kGenerationMask;
+
+		if (slot.generation == 0)
+		{
+			return;
+		}
+
+		slot.nextFree = mFirstFree;
+		mFirstFree = index;
+	}
+
+public:
+	explicit HandlePool(size_t initialCapacity = 32)
+	{
+		reserve(initialCapacity);
+	}
+
+	void reserve(size_t capacity)
+	{
+		mDense.reserve(capacity);
+		mDenseToSlot.reserve(capacity);
+		mSlots.reserve(capacity);
+	}
+
+	// Everything that can throw (capacity checks, allocations and the constructor
+	// of T) happens before a slot is taken, so a failed insert leaves the pool as
+	// it was.
+	template<typename... Args_t>
+	Handle_t insert(Args_t&&... args)
+	{
+		if (mFirstFree == kInvalidIndex)
+		{
+			if (mSlots.size() > Handle_t::kIndexMask)
+			{
+				throw std::overflow_error("handle pool is full");
+			}
+
+			reserveOneMore(mSlots);
+		}
+
+		reserveOneMore(mDenseToSlot);
+		mDense.emplace_back(std::forward<Args_t>(args)...);
+
+		const auto index = acquireSlot();
+		auto& slot = mSlots[index];
+
+		mDenseToSlot.push_back(index);
+		slot.denseIndex = static_cast<uint32_t>(mDense.size() - 1);
+
+		return Handle_t(index, slot.generation);
+	}
+
+	bool remove(Handle_t handle)
+	{
+		const auto slot = findSlot(handle);
+
+		if (slot == nullptr)
+		{
+			return false;
+		}
+
+		const auto denseIndex = slot->denseIndex;
+		const auto lastIndex = static_cast<uint32_t>(mDense.size() - 1);
+
+		if (denseIndex != lastIndex)
+		{
+			mDense[denseIndex] = std::move(mDense[lastIndex]);
+			mDenseToSlot[denseIndex] = mDenseToSlot[lastIndex];
+			mSlots[mDenseToSlot[denseIndex]].denseIndex = denseIndex;
+		}
+
+		mDense.pop_back();
+		mDenseToSlot.pop_back();
+		releaseSlot(handle.getIndex());
+		return true;
+	}
+
+	void clear()
+	{
+		for (auto index : mDenseToSlot)
+		{
+			releaseSlot(index);
+		}
+
+		mDense.clear();
+		mDenseToSlot.clear();
+	}
+
+	T* get(Handle_t handle)
+	{
+		const auto slot = findSlot(handle);
+		return slot != nullptr ? &mDense[slot->denseIndex] : nullptr;
+	}
+
+	const T* get(Handle_t handle) const
+	{
+		const auto slot = findSlot(handle);
+		return slot != nullptr ? &mDense[slot->denseIndex] : nullptr;
+	}
+
+	bool contains(Handle_t handle) const
+	{
+		return findSlot(handle) != nullptr;
+	}
+
+	// Handle of the object at a dense position, for use while iterating.
+	Handle_t getHandle(size_t denseIndex) const
+	{
+		const auto index = mDenseToSlot[denseIndex];
+		return Handle_t(index, mSlots[index].generation);
+	}
+
+	size_t size() const
+	{
+		return mDense.size();
+	}
+
+	bool empty() const
+	{
+		return mDense.empty();
+	}
+
+	T* data()
+	{
+		return mDense.data();
+	}
+
+	const T* data() const
+	{
+		return mDense.data();
+	}
+
+	Iterator_t begin()
+	{
+		return mDense.begin();
+	}
+
+	Iterator_t end()
+	{
+		return mDense.end();
+	}
+
+	ConstIterator_t begin() const
+	{
+		return mDense.begin();
+	}
+
+	ConstIterator_t end() const
+	{
+		return mDense.end();
+	}
+};
@@ -0,0 +1,127 @@
+#include "KeyTable.h"
+#include <mutex>
+#include <string.h>
+
+namespace Utils
+{
+    size_t KeyTable::KeyHash_s::operator()(const Key_s& key) const
+    {
+        size_t hash = 0;
+
+        for (size_t i = 0; i < key.length; i++)
+        {
+            hash = hash * 31 + static_cast<unsigned char>(key.name[i]);
+        }
+
+        return hash;
+    }
+
+    bool KeyTable::KeyEqual_s::operator()(const Key_s& left, const Key_s& right) const
+    {
+        return left.length == right.length && memcmp(left.name, right.name, left.length) == 0;
+    }
+
+    KeyTable::KeyTable()
+    {
+        for (auto& chunk : mChunks)
+        {
+            chunk.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    KeyTable::~KeyTable()
+    {
+        for (auto& chunk : mChunks)
+        {
+            delete[] chunk.load(std::memory_order_relaxed);
+        }
+    }
+
+    uint32_t KeyTable::intern(const char* key, size_t length)
+    {
+        const Key_s lookupKey{ key, length };
+
+        {
+            std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+            const auto it = mIds.find(lookupKey);
+
+            if (it != mIds.end())
+            {
+                return it->second;
+            }
+        }
+
+        std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+        const auto it = mIds.find(lookupKey);
+
+        if (it != mIds.end())
+        {
+            return it->second;
+        }
+
+        const auto id = mCount;
+        const auto chunkIndex = id >> kChunkShift;
+
+        if (chunkIndex >= kMaxChunks)
+        {
+            return kInvalidId;
+        }
+
+        auto chunk = mChunks[chunkIndex].load(std::memory_order_relaxed);
+
+        if (chunk == nullptr)
+        {
+            chunk = new std::string[kChunkSize];
+            mChunks[chunkIndex].store(chunk, std::memory_order_release);
+        }
+
+        auto& name = chunk[id & (kChunkSize - 1)];
+        name.assign(key, length);
+        mIds.emplace(Key_s{ name.c_str(), name.size() }, id);
+        mCount++;
+
+        return id;
+    }
+
+    uint32_t KeyTable::intern(const char* key)
+    {
+        return intern(key, strlen(key));
+    }
+
+    uint32_t KeyTable::find(const char* key, size_t length) const
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+        const auto it = mIds.find(Key_s{ key, length });
+        return it != mIds.end() ? it->second : kInvalidId;
+    }
+
+    uint32_t KeyTable::find(const char* key) const
+    {
+        return find(key, strlen(key));
+    }
+
+    const std::string& KeyTable::getName(uint32_t id) const
+    {
+        const auto chunk = mChunks[id >> kChunkShift].load(std::memory_order_acquire);
+        return chunk[id & (kChunkSize - 1)];
+    }
+
+    uint32_t KeyTable::size() const
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+        return mCount;
+    }
+
+    void KeyTable::clear()
+    {
+        std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+        mIds.clear();
+        mCount = 0;
+    }
+
+    KeyTable& KeyTable::instance()
+    {
+        static KeyTable sharedTable;
+        return sharedTable;
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <shared_mutex>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+
+namespace Utils
+{
+    class KeyTable
+    {
+    public:
+        static const uint32_t kInvalidId = 0xffffffffU;
+
+    private:
+        static const size_t kChunkShift = 10;
+        static const size_t kChunkSize = 1 << kChunkShift;
+        static const size_t kMaxChunks = 4096;
+
+        struct Key_s
+        {
+            const char* name;
+            size_t length;
+        };
+
+        struct KeyHash_s
+        {
+            size_t operator()(const Key_s& key) const;
+        };
+
+        struct KeyEqual_s
+        {
+            bool operator()(const Key_s& left, const Key_s& right) const;
+        };
+
+        mutable std::shared_timed_mutex mMutex;
+        std::unordered_map<Key_s, uint32_t, KeyHash_s, KeyEqual_s> mIds;
+        std::atomic<std::string*> mChunks[kMaxChunks];
+        uint32_t mCount = 0;
+
+        KeyTable(const KeyTable& source) = delete;
+        void operator=(const KeyTable& source) = delete;
+
+    public:
+        KeyTable();
+        ~KeyTable();
+
+        // Returns kInvalidId once the table holds kChunkSize * kMaxChunks keys;
+        // callers fall back to their own copy of the name.
+        uint32_t intern(const char* key, size_t length);
+        uint32_t intern(const char* key);
+        uint32_t find(const char* key, size_t length) const;
+        uint32_t find(const char* key) const;
+
+        const std::string& getName(uint32_t id) const;
+        uint32_t size() const;
+        // Forgets every id but keeps the name storage. Not safe while other threads
+        // use the table, so only scoped tables are cleared.
+        void clear();
+
+        // Shared table for keys written to diff output, which reference its names.
+        static KeyTable& instance();
+    };
+}
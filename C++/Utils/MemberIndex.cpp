@@ -0,0 +1,157 @@
+#include "MemberIndex.h"
+#include "utils/KeyTable.h"
+#include <mutex>
+#include <string.h>
+
+namespace Utils
+{
+    size_t MemberIndex::KeyHash_s::operator()(const Key_s& key) const
+    {
+        size_t hash = reinterpret_cast<size_t>(key.parent);
+
+        for (size_t i = 0; i < key.length; i++)
+        {
+            hash = hash * 31 + static_cast<unsigned char>(key.name[i]);
+        }
+
+        return hash;
+    }
+
+    bool MemberIndex::KeyEqual_s::operator()(const Key_s& left, const Key_s& right) const
+    {
+        return left.parent == right.parent &&
+            left.length == right.length &&
+            memcmp(left.name, right.name, left.length) == 0;
+    }
+
+    MemberIndex::MemberIndex(size_t minWidth) :
+        mMinWidth(minWidth)
+    {
+    }
+
+    void MemberIndex::indexObject(const input_value& object) const
+    {
+        for (auto m = object.MemberBegin(); m != object.MemberEnd(); ++m)
+        {
+            mMembers.emplace(Key_s{ &object, m->name.GetString(), m->name.GetStringLength() }, &*m);
+        }
+    }
+
+    void MemberIndex::indexValue(const input_value& value)
+    {
+        if (value.IsObject())
+        {
+            if (value.MemberCount() >= mMinWidth)
+            {
+                indexObject(value);
+            }
+
+            for (auto m = value.MemberBegin(); m != value.MemberEnd(); ++m)
+            {
+                indexValue(m->value);
+            }
+        }
+        else if (value.IsArray())
+        {
+            for (auto v = value.Begin(); v != value.End(); ++v)
+            {
+                indexValue(*v);
+            }
+        }
+    }
+
+    void MemberIndex::build(const input_value& root)
+    {
+        mMembers.clear();
+        mIndexedObjects.clear();
+        mKeyIds.clear();
+        indexValue(root);
+        mComplete = true;
+    }
+
+    void MemberIndex::clear()
+    {
+        mMembers.clear();
+        mIndexedObjects.clear();
+        mKeyIds.clear();
+        mComplete = false;
+    }
+
+    const input_value::Member* MemberIndex::lookup(const input_value& parent, const char* name) const
+    {
+        const auto it = mMembers.find(Key_s{ &parent, name, strlen(name) });
+        return it != mMembers.end() ? it->second : nullptr;
+    }
+
+    const input_value::Member* MemberIndex::find(const input_value& parent, const char* name) const
+    {
+        if (parent.MemberCount() < mMinWidth)
+        {
+            const auto member = parent.FindMember(name);
+            return member != parent.MemberEnd() ? &*member : nullptr;
+        }
+
+        if (mComplete)
+        {
+            return lookup(parent, name);
+        }
+
+        {
+            std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+
+            if (mIndexedObjects.count(&parent) != 0)
+            {
+                return lookup(parent, name);
+            }
+        }
+
+        std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+
+        if (mIndexedObjects.insert(&parent).second)
+        {
+            indexObject(parent);
+        }
+
+        return lookup(parent, name);
+    }
+
+    uint32_t MemberIndex::getKeyId(const char* name) const
+    {
+        {
+            std::shared_lock<std::shared_timed_mutex> lock(mMutex);
+            const auto it = mKeyIds.find(name);
+
+            if (it != mKeyIds.end())
+            {
+                return it->second;
+            }
+        }
+
+        std::unique_lock<std::shared_timed_mutex> lock(mMutex);
+        const auto it = mKeyIds.find(name);
+
+        if (it != mKeyIds.end())
+        {
+            return it->second;
+        }
+
+        const auto keyId = KeyTable::instance().intern(name);
+
+        if (keyId != KeyTable::kInvalidId)
+        {
+            mKeyIds.emplace(name, keyId);
+        }
+
+        return keyId;
+    }
+
+    void MemberIndex::setMinWidth(size_t minWidth)
+    {
+        mMinWidth = minWidth;
+    }
+
+    size_t MemberIndex::getMinWidth() const
+    {
+        return mMinWidth;
+    }
+}
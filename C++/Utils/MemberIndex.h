@@ -0,0 +1,60 @@
+#pragma once
+
+#include "data/static.h"
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace Utils
+{
+    class MemberIndex
+    {
+    private:
+        struct Key_s
+        {
+            const input_value* parent;
+            const char* name;
+            size_t length;
+        };
+
+        struct KeyHash_s
+        {
+            size_t operator()(const Key_s& key) const;
+        };
+
+        struct KeyEqual_s
+        {
+            bool operator()(const Key_s& left, const Key_s& right) const;
+        };
+
+        mutable std::shared_timed_mutex mMutex;
+        mutable std::unordered_map<Key_s, const input_value::Member*, KeyHash_s, KeyEqual_s> mMembers;
+        mutable std::unordered_set<const input_value*> mIndexedObjects;
+        mutable std::unordered_map<const char*, uint32_t> mKeyIds;
+        size_t mMinWidth;
+        bool mComplete = false;
+
+        MemberIndex(const MemberIndex& source) = delete;
+        void operator=(const MemberIndex& source) = delete;
+
+        void indexObject(const input_value& object) const;
+        void indexValue(const input_value& value);
+        const input_value::Member* lookup(const input_value& parent, const char* name) const;
+
+    public:
+        explicit MemberIndex(size_t minWidth = 32);
+
+        // Indexes every wide object under root up front; lookups take no lock.
+        void build(const input_value& root);
+        // Drops the index and switches to lazy mode: a wide object is indexed on its
+        // first lookup, so only objects the traversal actually reaches are hashed.
+        void clear();
+
+        const input_value::Member* find(const input_value& parent, const char* name) const;
+        // KeyTable id of a member name owned by the indexed document. Only names written
+        // to diff output are interned, each at most once per document, cached by pointer.
+        uint32_t getKeyId(const char* name) const;
+        void setMinWidth(size_t minWidth);
+        size_t getMinWidth() const;
+    };
+}
@@ -1,7 +1,13 @@
 #pragma once
 
+#include "utils/PoolCheckPolicy.h"
 #include <stdlib.h>
 #include <iostream>
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
 
 typedef void* RawPtr_t;
 
@@ -19,121 +25,278 @@ public:
 	}
 };
 
-template<typename T, class MemoryAllocator_t = DefaultMemoryAllocator>
-class ObjectPool
+// Slot alignment requested by a pool allocator through an optional static kAlignment;
+// pooled items are rounded up to it so that no slot straddles an alignment boundary.
+template<class MemoryAllocator_t, class = void>
+struct PoolAllocatorAlignment
 {
-private:
+	static const size_t value = sizeof(RawPtr_t);
+};
+
+template<class MemoryAllocator_t>
+struct PoolAllocatorAlignment<MemoryAllocator_t, decltype(void(MemoryAllocator_t::kAlignment))>
+{
+	static const size_t value = MemoryAllocator_t::kAlignment > sizeof(RawPtr_t) ? MemoryAllocator_t::kAlignment : sizeof(RawPtr_t);
+};
+
+// Chain of slot blocks shared by ObjectPool and ConcurrentObjectPool. Slots are handed
+// out front to back from the current block; when it runs out the chain advances to
+// the next kept block, or appends a new one twice the size, up to maxBlockLength.
+template<class MemoryAllocator_t>
+class PoolBlockChain
+{
+protected:
 	struct PoolNode_s
 	{
 		RawPtr_t nodeMemory;
 		size_t nodeCapacity;
-        PoolNode_s* nextNode;
+		size_t nodeBytes;
+		PoolNode_s* nextNode;
 
-        PoolNode_s(size_t capacity)
+		PoolNode_s(size_t capacity, size_t itemSize)
 		{
-            if (capacity < 1)
-            {
-                throw std::invalid_argument("capacity must be greater/equal 1");
-            }
-
-            nodeMemory = MemoryAllocator_t::allocate(sItemSize * capacity);
-
-            if (nodeMemory == nullptr)
-            {
-                throw std::bad_alloc();
-            }
-
-            nodeCapacity = capacity;
-            nextNode = nullptr;
+			if (capacity < 1)
+			{
+				throw std::invalid_argument("capacity must be greater/equal 1");
+			}
+
+			if (capacity > static_cast<size_t>(-1) / itemSize)
+			{
+				throw std::overflow_error("buffer overflow");
+			}
+
+			nodeBytes = itemSize * capacity;
+			nodeMemory = MemoryAllocator_t::allocate(nodeBytes);
+
+			if (nodeMemory == nullptr)
+			{
+				throw std::bad_alloc();
+			}
+
+			nodeCapacity = capacity;
+			nextNode = nullptr;
 		}
 
 		~PoolNode_s()
 		{
-            MemoryAllocator_t::deallocate(nodeMemory, sItemSize * nodeCapacity);
+			MemoryAllocator_t::deallocate(nodeMemory, nodeBytes);
 		}
 	};
 
-    RawPtr_t mNodeMemory;
-	T* mFirstDeleted;
+	const size_t mItemSize;
+	RawPtr_t mNodeMemory;
 	size_t mCountInNode;
 	size_t mNodeCapacity;
-    PoolNode_s mFirstNode;
-    PoolNode_s* mLastNode;
+	PoolNode_s mFirstNode;
+	PoolNode_s* mCurrentNode;
 	size_t mMaxBlockLength;
 
-    static const size_t sItemSize;
+	PoolBlockChain(const PoolBlockChain& source) = delete;
+	void operator=(const PoolBlockChain& source) = delete;
 
-private:
-	ObjectPool(const ObjectPool<T, MemoryAllocator_t>& source);
-	void operator=(const ObjectPool<T, MemoryAllocator_t>& source) = delete;
+	PoolBlockChain(size_t itemSize, size_t initialCapacity, size_t maxBlockLength) :
+		mItemSize(itemSize),
+		mCountInNode(0),
+		mNodeCapacity(initialCapacity),
+		mFirstNode(initialCapacity, itemSize),
+		mMaxBlockLength(maxBlockLength)
+	{
+		if (maxBlockLength < 1)
+		{
+			throw std::invalid_argument("maxBlockLength must be greater/equal 1");
+		}
+
+		mNodeMemory = mFirstNode.nodeMemory;
+		mCurrentNode = &mFirstNode;
+	}
+
+	~PoolBlockChain()
+	{
+		auto node = mFirstNode.nextNode;
+
+		while (node != nullptr)
+		{
+			auto nextNode = node->nextNode;
+			delete node;
+
+			node = nextNode;
+		}
+	}
 
 	void allocateNewNodeInternal()
 	{
+		if (mCurrentNode->nextNode != nullptr)
+		{
+			mCurrentNode = mCurrentNode->nextNode;
+			mNodeMemory = mCurrentNode->nodeMemory;
+			mCountInNode = 0;
+			mNodeCapacity = mCurrentNode->nodeCapacity;
+			return;
+		}
+
 		auto size = mCountInNode;
 
-        if (size >= mMaxBlockLength)
-        {
-            size = mMaxBlockLength;
-        }
+		if (size >= mMaxBlockLength)
+		{
+			size = mMaxBlockLength;
+		}
 		else
 		{
 			size *= 2;
 
-            if (size < mCountInNode)
-            {
-                throw std::overflow_error("buffer overflow");
-            }
+			if (size < mCountInNode)
+			{
+				throw std::overflow_error("buffer overflow");
+			}
 
-            if (size >= mMaxBlockLength)
-            {
-                size = mMaxBlockLength;
-            }
+			if (size >= mMaxBlockLength)
+			{
+				size = mMaxBlockLength;
+			}
 		}
 
-        auto newNode = new PoolNode_s(size);
+		auto newNode = new PoolNode_s(size, mItemSize);
 
-		mLastNode->nextNode = newNode;
-		mLastNode = newNode;
+		mCurrentNode->nextNode = newNode;
+		mCurrentNode = newNode;
 		mNodeMemory = newNode->nodeMemory;
 		mCountInNode = 0;
 		mNodeCapacity = size;
 	}
 
-public:
-	explicit ObjectPool(size_t initialCapacity = 32, size_t maxBlockLength = 1000000):
-		mFirstDeleted(nullptr),
-		mCountInNode(0),
-		mNodeCapacity(initialCapacity),
-		mFirstNode(initialCapacity),
-		mMaxBlockLength(maxBlockLength)
+	// Hands out up to count consecutive slots from the current block, moving to the
+	// next block first if the current one is exhausted.
+	char* takeSlots(size_t& count)
 	{
-        if (maxBlockLength < 1)
-        {
-            throw std::invalid_argument("maxBlockLength must be greater/equal 1");
-        }
+		if (mCountInNode >= mNodeCapacity)
+		{
+			allocateNewNodeInternal();
+		}
+
+		if (count > mNodeCapacity - mCountInNode)
+		{
+			count = mNodeCapacity - mCountInNode;
+		}
+
+		auto address = reinterpret_cast<char*>(mNodeMemory) + mCountInNode * mItemSize;
+		mCountInNode += count;
+		return address;
+	}
 
+	void rewind()
+	{
+		mCurrentNode = &mFirstNode;
 		mNodeMemory = mFirstNode.nodeMemory;
-		mLastNode = &mFirstNode;
+		mCountInNode = 0;
+		mNodeCapacity = mFirstNode.nodeCapacity;
+	}
+};
+
+template<typename T, class MemoryAllocator_t = DefaultMemoryAllocator, class CheckPolicy_t = DefaultPoolCheckPolicy>
+class ObjectPool : private CheckPolicy_t, private PoolBlockChain<MemoryAllocator_t>
+{
+public:
+	struct Stats_s
+	{
+		size_t blockCount = 0;
+		size_t emptyBlockCount = 0;
+		size_t capacity = 0;
+		size_t liveCount = 0;
+		size_t freeCount = 0;
+		size_t reservedBytes = 0;
+	};
+
+private:
+	typedef PoolBlockChain<MemoryAllocator_t> Chain_t;
+	typedef typename Chain_t::PoolNode_s PoolNode_s;
+
+	using Chain_t::mNodeMemory;
+	using Chain_t::mCountInNode;
+	using Chain_t::mNodeCapacity;
+	using Chain_t::mFirstNode;
+	using Chain_t::mCurrentNode;
+	using Chain_t::allocateNewNodeInternal;
+
+	T* mFirstDeleted;
+
+    static const size_t sItemSize;
+
+	struct BlockOccupancy_s
+	{
+		const PoolNode_s* node;
+		RawPtr_t memory;
+		size_t usedCount;
+		size_t freeCount;
+		bool dropFree;
+		bool release;
+	};
+
+private:
+	ObjectPool(const ObjectPool& source);
+	void operator=(const ObjectPool& source) = delete;
+
+	static bool compareBlocks(const BlockOccupancy_s& left, const BlockOccupancy_s& right)
+	{
+		return left.memory < right.memory;
+	}
+
+	static BlockOccupancy_s& findBlock(std::vector<BlockOccupancy_s>& blocks, const void* address)
+	{
+		auto it = std::upper_bound(blocks.begin(), blocks.end(), address,
+			[](const void* value, const BlockOccupancy_s& block)
+			{
+				return value < block.memory;
+			});
+
+		return *(it - 1);
 	}
 
-	~ObjectPool()
+	// Slots are handed out front to back, so every block before the current one
+	// is fully used and every block after it (kept by reset()) is untouched.
+	void collectOccupancy(std::vector<BlockOccupancy_s>& outBlocks) const
 	{
-        auto node = mFirstNode.nextNode;
+		auto beforeCurrent = true;
 
-		while(node != nullptr)
+		for (auto node = &mFirstNode; node != nullptr; node = node->nextNode)
 		{
-			auto nextNode = node->nextNode;
-			delete node;
+			size_t usedCount = 0;
+
+			if (node == mCurrentNode)
+			{
+				usedCount = mCountInNode;
+				beforeCurrent = false;
+			}
+			else if (beforeCurrent)
+			{
+				usedCount = node->nodeCapacity;
+			}
+
+			outBlocks.push_back(BlockOccupancy_s{ node, node->nodeMemory, usedCount, 0, false, false });
+		}
 
-			node = nextNode;
+		std::sort(outBlocks.begin(), outBlocks.end(), compareBlocks);
+
+		for (auto item = mFirstDeleted; item != nullptr; item = *((T**)item))
+		{
+			findBlock(outBlocks, item).freeCount++;
 		}
 	}
 
+public:
+	explicit ObjectPool(size_t initialCapacity = 32, size_t maxBlockLength = 1000000):
+		Chain_t(sItemSize, initialCapacity, maxBlockLength),
+		mFirstDeleted(nullptr)
+	{
+	}
+
+	using CheckPolicy_t::getCounters;
+
 	T* newPooled()
 	{
 		if (mFirstDeleted)
 		{
 			auto result = mFirstDeleted;
+			this->onAllocate(result, sizeof(T), true);
 			mFirstDeleted = *((T**)mFirstDeleted);
 
 			new (result) T();
@@ -147,6 +310,7 @@ public:
 
 		auto address = reinterpret_cast<char*>(mNodeMemory);
 		address += mCountInNode * sItemSize;
+		this->onAllocate(address, sizeof(T), false);
 		auto result = new (address) T();
 		mCountInNode++;
 
@@ -158,6 +322,7 @@ public:
 		if (mFirstDeleted)
 		{
 			auto result = (T*)mFirstDeleted;
+			this->onAllocate(result, sizeof(T), true);
             mFirstDeleted = *((T**)mFirstDeleted);
 
 			return result;
@@ -170,6 +335,7 @@ public:
 
 		auto address = reinterpret_cast<char*>(mNodeMemory);
 		address += mCountInNode * sItemSize;
+		this->onAllocate(address, sizeof(T), false);
 		mCountInNode++;
 
 		return (T*)address;
@@ -177,7 +343,9 @@ public:
 
 	void deletePooled(T* content)
 	{
+		this->onRelease(content, sizeof(T));
 		content->~T();
+		this->onReleased(content, sizeof(T));
 
 		*((T**)content) = mFirstDeleted;
 		mFirstDeleted = content;
@@ -185,10 +353,174 @@ public:
 
 	void deleteWithoutDestroying(T* content)
 	{
+		this->onRelease(content, sizeof(T));
+		this->onReleased(content, sizeof(T));
+
 		*((T**)content) = mFirstDeleted;
 		mFirstDeleted = content;
 	}
+
+	void allocateBatch(T** outItems, size_t count)
+	{
+		size_t index = 0;
+
+		while (index < count && mFirstDeleted)
+		{
+			auto result = mFirstDeleted;
+			this->onAllocate(result, sizeof(T), true);
+			mFirstDeleted = *((T**)mFirstDeleted);
+
+			outItems[index++] = new (result) T();
+		}
+
+		while (index < count)
+		{
+			auto available = count - index;
+			auto address = this->takeSlots(available);
+
+			for (size_t i = 0; i < available; i++, address += sItemSize)
+			{
+				this->onAllocate(address, sizeof(T), false);
+				outItems[index++] = new (address) T();
+			}
+		}
+	}
+
+	void releaseBatch(T* const* items, size_t count)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			this->onRelease(items[i], sizeof(T));
+			items[i]->~T();
+			this->onReleased(items[i], sizeof(T));
+			*((T**)items[i]) = i + 1 < count ? items[i + 1] : mFirstDeleted;
+		}
+
+		mFirstDeleted = items[0];
+	}
+
+	// Drops every live object without running destructors and rewinds to the
+	// first block; the blocks themselves are kept and refilled in order. Only
+	// available for trivially destructible T: release other objects individually
+	// or with releaseBatch().
+	void reset()
+	{
+		static_assert(std::is_trivially_destructible<T>::value, "ObjectPool::reset() would skip destructors of T");
+
+		this->onReset();
+		mFirstDeleted = nullptr;
+		this->rewind();
+	}
+
+	// Returns fully empty blocks to MemoryAllocator_t, keeping up to keepEmptyBlocks
+	// of them for reuse. The first and the current block are never released.
+	size_t shrink(size_t keepEmptyBlocks = 0)
+	{
+		std::vector<BlockOccupancy_s> blocks;
+		collectOccupancy(blocks);
+
+		auto dropFree = false;
+		size_t keptCount = 0;
+		size_t releasedCount = 0;
+
+		for (auto& block : blocks)
+		{
+			if (block.usedCount != block.freeCount)
+			{
+				continue;
+			}
+
+			if (block.node == mCurrentNode)
+			{
+				block.dropFree = block.freeCount > 0;
+			}
+			else if (block.node != &mFirstNode && keptCount >= keepEmptyBlocks)
+			{
+				block.dropFree = block.freeCount > 0;
+				block.release = true;
+			}
+			else
+			{
+				keptCount++;
+			}
+
+			dropFree = dropFree || block.dropFree;
+		}
+
+		if (dropFree)
+		{
+			auto link = &mFirstDeleted;
+
+			while (*link != nullptr)
+			{
+				auto item = *link;
+
+				if (findBlock(blocks, item).dropFree)
+				{
+					*link = *((T**)item);
+				}
+				else
+				{
+					link = (T**)item;
+				}
+			}
+
+			if (findBlock(blocks, mNodeMemory).dropFree)
+			{
+				mCountInNode = 0;
+			}
+		}
+
+		for (auto node = &mFirstNode; node->nextNode != nullptr;)
+		{
+			auto next = node->nextNode;
+
+			if (findBlock(blocks, next->nodeMemory).release)
+			{
+				node->nextNode = next->nextNode;
+				delete next;
+				releasedCount++;
+			}
+			else
+			{
+				node = next;
+			}
+		}
+
+		return releasedCount;
+	}
+
+	Stats_s getStats() const
+	{
+		std::vector<BlockOccupancy_s> blocks;
+		collectOccupancy(blocks);
+
+		Stats_s stats;
+
+		for (const auto& block : blocks)
+		{
+			stats.blockCount++;
+			stats.capacity += block.node->nodeCapacity;
+			stats.reservedBytes += block.node->nodeCapacity * sItemSize;
+			stats.liveCount += block.usedCount - block.freeCount;
+			stats.freeCount += block.freeCount;
+
+			if (block.usedCount == block.freeCount)
+			{
+				stats.emptyBlockCount++;
+			}
+		}
+
+		return stats;
+	}
 };
 
-template<typename T, class MemoryAllocator_t>
-const size_t ObjectPool<T, MemoryAllocator_t>::sItemSize = ((sizeof(T) + sizeof(RawPtr_t) - 1) / sizeof(RawPtr_t)) * sizeof(RawPtr_t);
\ No newline at end of file
+template<typename T, class MemoryAllocator_t, class CheckPolicy_t>
+const size_t ObjectPool<T, MemoryAllocator_t, CheckPolicy_t>::sItemSize =
+	((sizeof(T) + sizeof(RawPtr_t) - 1) / sizeof(RawPtr_t) * sizeof(RawPtr_t) + CheckPolicy_t::kSlotPadding + PoolAllocatorAlignment<MemoryAllocator_t>::value - 1) /
+	PoolAllocatorAlignment<MemoryAllocator_t>::value * PoolAllocatorAlignment<MemoryAllocator_t>::value;
\ No newline at end of file
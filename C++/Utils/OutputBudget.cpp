@@ -0,0 +1,98 @@
+#include "OutputBudget.h"
+
+namespace Utils
+{
+    OutputBudget::OutputBudget(size_t limit) :
+        mLimit(limit),
+        mUsed(0),
+        mExceeded(false)
+    {
+    }
+
+    void OutputBudget::reset(size_t limit)
+    {
+        mLimit = limit;
+        mUsed = 0;
+        mExceeded = false;
+    }
+
+    bool OutputBudget::charge(size_t bytes)
+    {
+        if (mLimit == 0)
+        {
+            return true;
+        }
+
+        if (mUsed.fetch_add(bytes, std::memory_order_relaxed) + bytes > mLimit)
+        {
+            mExceeded.store(true, std::memory_order_relaxed);
+        }
+
+        return !isExceeded();
+    }
+
+    bool OutputBudget::isExceeded() const
+    {
+        return mExceeded.load(std::memory_order_relaxed);
+    }
+
+    size_t OutputBudget::getUsed() const
+    {
+        return mUsed.load(std::memory_order_relaxed);
+    }
+
+    size_t OutputBudget::getLimit() const
+    {
+        return mLimit;
+    }
+
+    void OutputMeter::attach(OutputBudget* budget, const input_value::AllocatorType* allocatorModify,
+        const input_value::AllocatorType* allocatorDelete, const BinaryDiffWriter* binaryOutput)
+    {
+        mBudget = budget;
+        mAllocatorModify = allocatorModify;
+        mAllocatorDelete = allocatorDelete != allocatorModify ? allocatorDelete : nullptr;
+        mBinaryOutput = binaryOutput;
+        mModifySize = mAllocatorModify != nullptr ? mAllocatorModify->Size() : 0;
+        mDeleteSize = mAllocatorDelete != nullptr ? mAllocatorDelete->Size() : 0;
+        mBinarySize = mBinaryOutput != nullptr ? mBinaryOutput->getBuffer().size() : 0;
+    }
+
+    bool OutputMeter::update()
+    {
+        if (mBudget == nullptr)
+        {
+            return true;
+        }
+
+        size_t delta = 0;
+
+        if (mAllocatorModify != nullptr)
+        {
+            const auto size = mAllocatorModify->Size();
+            delta += size > mModifySize ? size - mModifySize : 0;
+            mModifySize = size;
+        }
+
+        if (mAllocatorDelete != nullptr)
+        {
+            const auto size = mAllocatorDelete->Size();
+            delta += size > mDeleteSize ? size - mDeleteSize : 0;
+            mDeleteSize = size;
+        }
+
+        if (mBinaryOutput != nullptr)
+        {
+            const auto size = mBinaryOutput->getBuffer().size();
+            delta += size > mBinarySize ? size - mBinarySize : 0;
+            mBinarySize = size;
+        }
+
+        return delta == 0 ? !mBudget->isExceeded() : mBudget->charge(delta);
+    }
+
+    bool OutputMeter::isExceeded() const
+    {
+        return mBudget != nullptr && mBudget->isExceeded();
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "utils/BinaryDiff.h"
+#include "data/static.h"
+#include <atomic>
+
+namespace Utils
+{
+    class OutputBudget
+    {
+    private:
+        size_t mLimit = 0;
+        std::atomic<size_t> mUsed;
+        std::atomic<bool> mExceeded;
+
+        OutputBudget(const OutputBudget& source) = delete;
+        void operator=(const OutputBudget& source) = delete;
+
+    public:
+        explicit OutputBudget(size_t limit = 0);
+
+        void reset(size_t limit);
+        bool charge(size_t bytes);
+
+        bool isExceeded() const;
+        size_t getUsed() const;
+        size_t getLimit() const;
+    };
+
+    class OutputMeter
+    {
+    private:
+        OutputBudget* mBudget = nullptr;
+        const input_value::AllocatorType* mAllocatorModify = nullptr;
+        const input_value::AllocatorType* mAllocatorDelete = nullptr;
+        const BinaryDiffWriter* mBinaryOutput = nullptr;
+        size_t mModifySize = 0;
+        size_t mDeleteSize = 0;
+        size_t mBinarySize = 0;
+
+    public:
+        void attach(OutputBudget* budget, const input_value::AllocatorType* allocatorModify,
+            const input_value::AllocatorType* allocatorDelete, const BinaryDiffWriter* binaryOutput = nullptr);
+
+        bool update();
+        bool isExceeded() const;
+    };
+}
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "utils/ObjectPool.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#else
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+template<size_t Alignment>
+class AlignedMemoryAllocator
+{
+public:
+	static const size_t kAlignment = Alignment;
+
+	static inline RawPtr_t allocate(size_t size)
+	{
+#if defined(_WIN32)
+		return _aligned_malloc(size, kAlignment);
+#else
+		RawPtr_t pointer = nullptr;
+		return posix_memalign(&pointer, kAlignment, size) == 0 ? pointer : nullptr;
+#endif
+	}
+
+	static inline void deallocate(RawPtr_t pointer, size_t size)
+	{
+#if defined(_WIN32)
+		_aligned_free(pointer);
+#else
+		free(pointer);
+#endif
+	}
+};
+
+// Slots start on and are padded to a cache line, so items owned by different
+// threads never share one.
+typedef AlignedMemoryAllocator<64> CacheAlignedMemoryAllocator;
+
+// Blocks are mapped in whole 2MB pages starting on a 2MB boundary and advised as
+// transparent huge pages, which cuts TLB misses for large pools. mmap only promises
+// page alignment, so each block over-maps by one huge page and unmaps the misaligned
+// head and tail. Falls back to cache aligned heap memory where mmap is not available.
+class HugePageMemoryAllocator
+{
+public:
+	static const size_t kAlignment = 64;
+	static const size_t kHugePageSize = 2 * 1024 * 1024;
+
+	static inline size_t getMappedSize(size_t size)
+	{
+		return (size + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+	}
+
+	static inline RawPtr_t allocate(size_t size)
+	{
+#if defined(__linux__)
+		const auto mappedSize = getMappedSize(size);
+		auto reserved = mmap(nullptr, mappedSize + kHugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (reserved == MAP_FAILED)
+		{
+			return nullptr;
+		}
+
+		const auto reservedAddress = reinterpret_cast<uintptr_t>(reserved);
+		const auto alignedAddress = (reservedAddress + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+		const auto headSize = alignedAddress - reservedAddress;
+		const auto tailSize = kHugePageSize - headSize;
+		auto pointer = reinterpret_cast<RawPtr_t>(alignedAddress);
+
+		if (headSize > 0)
+		{
+			munmap(reserved, headSize);
+		}
+
+		if (tailSize > 0)
+		{
+			munmap(reinterpret_cast<char*>(pointer) + mappedSize, tailSize);
+		}
+
+#if defined(MADV_HUGEPAGE)
+		madvise(pointer, mappedSize, MADV_HUGEPAGE);
+#endif
+
+		return pointer;
+#else
+		return CacheAlignedMemoryAllocator::allocate(size);
+#endif
+	}
+
+	static inline void deallocate(RawPtr_t pointer, size_t size)
+	{
+#if defined(__linux__)
+		munmap(pointer, getMappedSize(size));
+#else
+		CacheAlignedMemoryAllocator::deallocate(pointer, size);
+#endif
+	}
+};
+
+// Relies on the kernel's first-touch placement: every page of a new block is freshly
+// mapped and then written by the allocating thread, so the block lands on that
+// thread's NUMA node instead of wherever the first pooled object happens to be
+// constructed. Placement is only as good as the allocating thread's affinity; no
+// memory policy is bound, so a thread that migrates later keeps remote blocks.
+// Outside Linux it degrades to page aligned heap memory, which may reuse pages
+// already placed elsewhere.
+class NumaLocalMemoryAllocator
+{
+public:
+	static const size_t kAlignment = 64;
+
+	static inline size_t getPageSize()
+	{
+#if defined(_WIN32)
+		return 4096;
+#else
+		static const size_t sPageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+		return sPageSize;
+#endif
+	}
+
+	static inline size_t getMappedSize(size_t size)
+	{
+		const auto pageSize = getPageSize();
+		return (size + pageSize - 1) / pageSize * pageSize;
+	}
+
+	static inline RawPtr_t allocate(size_t size)
+	{
+		const auto pageSize = getPageSize();
+#if defined(__linux__)
+		auto pointer = mmap(nullptr, getMappedSize(size), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if (pointer == MAP_FAILED)
+		{
+			return nullptr;
+		}
+#elif defined(_WIN32)
+		auto pointer = _aligned_malloc(size, pageSize);
+#else
+		RawPtr_t pointer = nullptr;
+
+		if (posix_memalign(&pointer, pageSize, size) != 0)
+		{
+			return nullptr;
+		}
+#endif
+
+		if (pointer != nullptr)
+		{
+			auto bytes = reinterpret_cast<char*>(pointer);
+
+			for (size_t offset = 0; offset < size; offset += pageSize)
+			{
+				bytes[offset] = 0;
+			}
+		}
+
+		return pointer;
+	}
+
+	static inline void deallocate(RawPtr_t pointer, size_t size)
+	{
+#if defined(__linux__)
+		munmap(pointer, getMappedSize(size));
+#elif defined(_WIN32)
+		_aligned_free(pointer);
+#else
+		free(pointer);
+#endif
+	}
+};
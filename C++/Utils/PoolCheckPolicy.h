@@ -0,0 +1,158 @@
+#pragma once
+
+#include "utils/PoolConfig.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <iostream>
+#include <unordered_set>
+
+struct PoolCounters_s
+{
+	size_t allocations = 0;
+	size_t releases = 0;
+	size_t live = 0;
+	size_t peak = 0;
+	double allocationsPerSecond = 0.0;
+};
+
+// Default ObjectPool policy: empty, so the pool stores nothing extra for it and
+// every hook inlines away.
+class NullPoolCheckPolicy
+{
+protected:
+	static const size_t kSlotPadding = 0;
+
+	inline void onAllocate(void*, size_t, bool) {}
+	inline void onRelease(void*, size_t) {}
+	inline void onReleased(void*, size_t) {}
+	inline void onReset() {}
+
+public:
+	inline PoolCounters_s getCounters() const
+	{
+		return PoolCounters_s();
+	}
+};
+
+// Appends a canary to every slot, poisons released objects, and keeps a live set so
+// double frees, overruns and writes through stale pointers abort at the faulting
+// call instead of corrupting the free list. Objects still live when the pool is
+// destroyed are reported as leaks. Not thread safe.
+class CheckedPoolCheckPolicy
+{
+private:
+	static const uint64_t kCanary = 0x5afec0dedeadbeefULL;
+	static const unsigned char kPoison = 0xdd;
+
+	std::unordered_set<const void*> mLive;
+	size_t mAllocations = 0;
+	size_t mReleases = 0;
+	size_t mPeak = 0;
+	std::chrono::steady_clock::time_point mStart = std::chrono::steady_clock::now();
+
+	static size_t getCanaryOffset(size_t objectSize)
+	{
+		return (objectSize + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+	}
+
+	static void fail(const char* message, const void* item)
+	{
+		std::cerr << "ObjectPool: " << message << " at " << item << std::endl;
+		abort();
+	}
+
+protected:
+	static const size_t kSlotPadding = sizeof(uint64_t);
+
+	void onAllocate(void* item, size_t objectSize, bool recycled)
+	{
+		auto bytes = reinterpret_cast<unsigned char*>(item);
+		const auto canaryOffset = getCanaryOffset(objectSize);
+
+		if (recycled)
+		{
+			for (auto offset = sizeof(void*); offset < canaryOffset; offset++)
+			{
+				if (bytes[offset] != kPoison)
+				{
+					fail("released object was written to", item);
+				}
+			}
+		}
+
+		memcpy(bytes + canaryOffset, &kCanary, sizeof(kCanary));
+		mLive.insert(item);
+		mAllocations++;
+
+		if (mLive.size() > mPeak)
+		{
+			mPeak = mLive.size();
+		}
+	}
+
+	void onRelease(void* item, size_t objectSize)
+	{
+		if (mLive.erase(item) == 0)
+		{
+			fail("double free or foreign pointer", item);
+		}
+
+		uint64_t canary = 0;
+		memcpy(&canary, reinterpret_cast<unsigned char*>(item) + getCanaryOffset(objectSize), sizeof(canary));
+
+		if (canary != kCanary)
+		{
+			fail("write past the end of object", item);
+		}
+
+		mReleases++;
+	}
+
+	void onReleased(void* item, size_t objectSize)
+	{
+		const auto canaryOffset = getCanaryOffset(objectSize);
+
+		if (canaryOffset > sizeof(void*))
+		{
+			memset(reinterpret_cast<unsigned char*>(item) + sizeof(void*), kPoison, canaryOffset - sizeof(void*));
+		}
+	}
+
+	void onReset()
+	{
+		mReleases += mLive.size();
+		mLive.clear();
+	}
+
+	~CheckedPoolCheckPolicy()
+	{
+		if (!mLive.empty())
+		{
+			std::cerr << "ObjectPool: " << mLive.size() << " objects leaked" << std::endl;
+		}
+	}
+
+public:
+	PoolCounters_s getCounters() const
+	{
+		PoolCounters_s counters;
+		counters.allocations = mAllocations;
+		counters.releases = mReleases;
+		counters.live = mLive.size();
+		counters.peak = mPeak;
+
+		const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - mStart).count();
+		counters.allocationsPerSecond = elapsed > 0.0 ? mAllocations / elapsed : 0.0;
+		return counters;
+	}
+};
+
+// Selected once for the whole build through PoolConfig.h, so every translation unit
+// sees the same ObjectPool<T> type.
+#if OBJECT_POOL_CHECKED
+typedef CheckedPoolCheckPolicy DefaultPoolCheckPolicy;
+#else
+typedef NullPoolCheckPolicy DefaultPoolCheckPolicy;
+#endif
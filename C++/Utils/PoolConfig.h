@@ -0,0 +1,18 @@
+#pragma once
+
+// Build-wide ObjectPool settings. The default check policy is part of every
+// ObjectPool<T> type, so all translation units have to agree on these values:
+// change them here or define them for the whole build, never per file.
+
+// 1 makes CheckedPoolCheckPolicy the default policy of every ObjectPool.
+#ifndef OBJECT_POOL_CHECKED
+#define OBJECT_POOL_CHECKED 0
+#endif
+
+#if defined(_MSC_VER)
+#if OBJECT_POOL_CHECKED
+#pragma detect_mismatch("OBJECT_POOL_CHECKED", "1")
+#else
+#pragma detect_mismatch("OBJECT_POOL_CHECKED", "0")
+#endif
+#endif
@@ -0,0 +1,343 @@
+#include "SharedSnapshot.h"
+#include <algorithm>
+#include <string.h>
+
+namespace Utils
+{
+    namespace
+    {
+        const size_t kChunkAllocatorCapacity = 1024;
+
+        bool compareChildren(const SharedSnapshot::Node_s::Child_t& left, const SharedSnapshot::Node_s::Child_t& right)
+        {
+            return left.first < right.first;
+        }
+
+        bool compareNames(const input_value* left, const input_value* right)
+        {
+            return strcmp(left->GetString(), right->GetString()) < 0;
+        }
+
+        bool equalNames(const input_value* left, const input_value* right)
+        {
+            return strcmp(left->GetString(), right->GetString()) == 0;
+        }
+
+        SharedSnapshot::Node_s::ChildChunk_t::iterator findChild(SharedSnapshot::Node_s::ChildChunk_t& chunk, const char* name)
+        {
+            return std::lower_bound(chunk.begin(), chunk.end(), name,
+                [](const SharedSnapshot::Node_s::Child_t& child, const char* key)
+                {
+                    return strcmp(child.first.c_str(), key) < 0;
+                });
+        }
+
+        void collectNames(const input_value* diff, std::vector<const input_value*>& outNames)
+        {
+            if (diff == nullptr || !diff->IsObject())
+            {
+                return;
+            }
+
+            for (auto m = diff->MemberBegin(); m != diff->MemberEnd(); ++m)
+            {
+                outNames.push_back(&m->name);
+            }
+        }
+
+        const input_value* findDiffMember(const input_value* diff, const input_value& name)
+        {
+            if (diff == nullptr || !diff->IsObject())
+            {
+                return nullptr;
+            }
+
+            const auto member = diff->FindMember(name);
+            return member != diff->MemberEnd() ? &member->value : nullptr;
+        }
+    }
+
+    const SharedSnapshot::Node_s* SharedSnapshot::Node_s::find(const char* name) const
+    {
+        auto chunk = std::upper_bound(childChunks.begin(), childChunks.end(), name,
+            [](const char* key, const std::shared_ptr<const ChildChunk_t>& candidate)
+            {
+                return strcmp(key, candidate->front().first.c_str()) < 0;
+            });
+
+        if (chunk == childChunks.begin())
+        {
+            return nullptr;
+        }
+
+        const auto& children = **(chunk - 1);
+        const auto it = std::lower_bound(children.begin(), children.end(), name,
+            [](const Child_t& child, const char* key)
+            {
+                return strcmp(child.first.c_str(), key) < 0;
+            });
+
+        if (it == children.end() || it->first != name)
+        {
+            return nullptr;
+        }
+
+        return it->second.get();
+    }
+
+    bool SharedSnapshot::Node_s::equals(const input_value& other) const
+    {
+        if (!isBranch)
+        {
+            return value == other;
+        }
+
+        if (!other.IsObject() || other.MemberCount() != childCount)
+        {
+            return false;
+        }
+
+        for (auto m = other.MemberBegin(); m != other.MemberEnd(); ++m)
+        {
+            const auto child = find(m->name.GetString());
+
+            if (child == nullptr || !child->equals(m->value))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    void SharedSnapshot::addChunk(Node_s& node, Node_s::ChildChunk_t& chunk)
+    {
+        for (size_t offset = 0; offset < chunk.size(); )
+        {
+            // An edited chunk is kept whole until it doubles, then split evenly.
+            const auto remaining = chunk.size() - offset;
+            const auto count = remaining <= 2 * kChildChunkSize ? remaining : kChildChunkSize;
+            const auto first = chunk.begin() + offset;
+
+            node.childChunks.emplace_back(std::make_shared<Node_s::ChildChunk_t>(
+                std::make_move_iterator(first), std::make_move_iterator(first + count)));
+            node.childCount += count;
+            offset += count;
+        }
+    }
+
+    SharedSnapshot::NodePtr_t SharedSnapshot::buildNode(const input_value& value, size_t depth)
+    {
+        std::shared_ptr<Node_s> node(new Node_s());
+
+        if (depth > 0 && value.IsObject())
+        {
+            Node_s::ChildChunk_t children;
+            children.reserve(value.MemberCount());
+
+            for (auto m = value.MemberBegin(); m != value.MemberEnd(); ++m)
+            {
+                children.emplace_back(std::string(m->name.GetString(), m->name.GetStringLength()), buildNode(m->value, depth - 1));
+            }
+
+            std::sort(children.begin(), children.end(), compareChildren);
+            node->isBranch = true;
+            node->childChunks.reserve(children.size() / kChildChunkSize + 1);
+            addChunk(*node, children);
+            return node;
+        }
+
+        node->allocator.reset(new input_value::AllocatorType(kChunkAllocatorCapacity));
+        node->value.CopyFrom(value, *node->allocator);
+        return node;
+    }
+
+    void SharedSnapshot::rotateChild(Node_s::ChildChunk_t& chunk, const input_value& name, const input_value& value,
+        const input_value* diffModify, const input_value* diffDelete, size_t depth)
+    {
+        const auto member = value.FindMember(name);
+        const auto prevChild = findChild(chunk, name.GetString());
+        const auto hasPrevChild = prevChild != chunk.end() && prevChild->first == name.GetString();
+
+        if (member == value.MemberEnd())
+        {
+            if (hasPrevChild)
+            {
+                chunk.erase(prevChild);
+            }
+
+            return;
+        }
+
+        const auto modifyChild = findDiffMember(diffModify, name);
+        const auto deleteChild = findDiffMember(diffDelete, name);
+
+        if (!hasPrevChild)
+        {
+            chunk.emplace(prevChild, std::string(name.GetString(), name.GetStringLength()), buildNode(member->value, depth - 1));
+        }
+        else if ((modifyChild == nullptr || modifyChild->IsObject()) && (deleteChild == nullptr || deleteChild->IsObject()))
+        {
+            prevChild->second = rotateNode(prevChild->second, member->value, modifyChild, deleteChild, depth - 1);
+        }
+        else
+        {
+            prevChild->second = buildNode(member->value, depth - 1);
+        }
+    }
+
+    SharedSnapshot::NodePtr_t SharedSnapshot::rotateNode(const NodePtr_t& prev, const input_value& value,
+        const input_value* diffModify, const input_value* diffDelete, size_t depth)
+    {
+        if (prev == nullptr || !prev->isBranch || depth == 0 || !value.IsObject())
+        {
+            return buildNode(value, depth);
+        }
+
+        std::vector<const input_value*> changed;
+        collectNames(diffModify, changed);
+        collectNames(diffDelete, changed);
+        std::sort(changed.begin(), changed.end(), compareNames);
+        changed.erase(std::unique(changed.begin(), changed.end(), equalNames), changed.end());
+
+        std::shared_ptr<Node_s> node(new Node_s());
+        node->isBranch = true;
+        node->childChunks.reserve(prev->childChunks.size() + 1);
+
+        const auto chunkCount = prev->childChunks.size();
+        auto next = changed.begin();
+
+        for (size_t i = 0; i < chunkCount || next != changed.end(); i++)
+        {
+            // A chunk owns the changed names that sort before the next chunk's first name.
+            auto end = changed.end();
+
+            if (i + 1 < chunkCount)
+            {
+                const auto& boundary = prev->childChunks[i + 1]->front().first;
+                end = std::lower_bound(next, changed.end(), boundary.c_str(),
+                    [](const input_value* name, const char* key)
+                    {
+                        return strcmp(name->GetString(), key) < 0;
+                    });
+            }
+
+            if (i < chunkCount && next == end)
+            {
+                node->childChunks.push_back(prev->childChunks[i]);
+                node->childCount += prev->childChunks[i]->size();
+                continue;
+            }
+
+            auto chunk = i < chunkCount ? *prev->childChunks[i] : Node_s::ChildChunk_t();
+
+            for (; next != end; ++next)
+            {
+                rotateChild(chunk, **next, value, diffModify, diffDelete, depth);
+            }
+
+            addChunk(*node, chunk);
+        }
+
+        return node;
+    }
+
+    void SharedSnapshot::materializeNode(const Node_s& node, input_value& out, input_value::AllocatorType& allocator)
+    {
+        if (!node.isBranch)
+        {
+            out.CopyFrom(node.value, allocator);
+            return;
+        }
+
+        out.SetObject();
+
+        for (const auto& chunk : node.childChunks)
+        {
+            for (const auto& child : *chunk)
+            {
+                input_value name(child.first.c_str(), static_cast<rapidjson::SizeType>(child.first.size()), allocator);
+                input_value value;
+                materializeNode(*child.second, value, allocator);
+                out.AddMember(name, value, allocator);
+            }
+        }
+    }
+
+    SharedSnapshot SharedSnapshot::fromDocument(const input_value& document, size_t depth)
+    {
+        SharedSnapshot snapshot;
+        snapshot.mRoot = buildNode(document, depth);
+        snapshot.mDepth = depth;
+        return snapshot;
+    }
+
+    SharedSnapshot SharedSnapshot::rotate(const input_value& document, const input_value& diffModify, const input_value& diffDelete) const
+    {
+        SharedSnapshot snapshot;
+        snapshot.mRoot = rotateNode(mRoot, document, &diffModify, &diffDelete, mDepth);
+        snapshot.mDepth = mDepth;
+        return snapshot;
+    }
+
+    void SharedSnapshot::materialize(input_value& out, input_value::AllocatorType& allocator) const
+    {
+        if (mRoot == nullptr)
+        {
+            out.SetNull();
+            return;
+        }
+
+        materializeNode(*mRoot, out, allocator);
+    }
+
+    const SharedSnapshot::Node_s* SharedSnapshot::root() const
+    {
+        return mRoot.get();
+    }
+
+    size_t SharedSnapshot::getDepth() const
+    {
+        return mDepth;
+    }
+
+    bool SharedSnapshot::empty() const
+    {
+        return mRoot == nullptr;
+    }
+
+    SnapshotHistory::SnapshotHistory(size_t capacity) :
+        mCapacity(std::max<size_t>(capacity, 1))
+    {
+    }
+
+    void SnapshotHistory::push(const SharedSnapshot& snapshot)
+    {
+        mSnapshots.push_front(snapshot);
+
+        while (mSnapshots.size() > mCapacity)
+        {
+            mSnapshots.pop_back();
+        }
+    }
+
+    void SnapshotHistory::clear()
+    {
+        mSnapshots.clear();
+    }
+
+    const SharedSnapshot* SnapshotHistory::latest() const
+    {
+        return at(0);
+    }
+
+    const SharedSnapshot* SnapshotHistory::at(size_t age) const
+    {
+        return age < mSnapshots.size() ? &mSnapshots[age] : nullptr;
+    }
+
+    size_t SnapshotHistory::size() const
+    {
+        return mSnapshots.size();
+    }
+}
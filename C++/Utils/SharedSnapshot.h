@@ -0,0 +1,80 @@
+#pragma once
+
+#include "data/static.h"
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Utils
+{
+    class SharedSnapshot
+    {
+    public:
+        struct Node_s;
+        typedef std::shared_ptr<const Node_s> NodePtr_t;
+
+        struct Node_s
+        {
+            typedef std::pair<std::string, NodePtr_t> Child_t;
+            typedef std::vector<Child_t> ChildChunk_t;
+
+            bool isBranch = false;
+            // Children sorted by name and split into chunks, so a rotation copies only
+            // the chunks holding changed names and shares the rest with the previous node.
+            std::vector<std::shared_ptr<const ChildChunk_t>> childChunks;
+            size_t childCount = 0;
+            std::unique_ptr<input_value::AllocatorType> allocator;
+            input_value value;
+
+            const Node_s* find(const char* name) const;
+            bool equals(const input_value& other) const;
+        };
+
+    private:
+        NodePtr_t mRoot;
+        size_t mDepth = 0;
+
+        static const size_t kChildChunkSize = 32;
+
+        static NodePtr_t buildNode(const input_value& value, size_t depth);
+        static void addChunk(Node_s& node, Node_s::ChildChunk_t& chunk);
+        static void rotateChild(Node_s::ChildChunk_t& chunk, const input_value& name, const input_value& value,
+            const input_value* diffModify, const input_value* diffDelete, size_t depth);
+        static NodePtr_t rotateNode(const NodePtr_t& prev, const input_value& value,
+            const input_value* diffModify, const input_value* diffDelete, size_t depth);
+        static void materializeNode(const Node_s& node, input_value& out, input_value::AllocatorType& allocator);
+
+    public:
+        SharedSnapshot() = default;
+
+        static SharedSnapshot fromDocument(const input_value& document, size_t depth = 2);
+        // diffModify and diffDelete must be the DOM diffs that took this snapshot to
+        // document; only the members they name are rebuilt. Use
+        // DiffGenerator::rotateSharedSnapshot, which refuses when they are unusable.
+        SharedSnapshot rotate(const input_value& document, const input_value& diffModify, const input_value& diffDelete) const;
+
+        void materialize(input_value& out, input_value::AllocatorType& allocator) const;
+
+        const Node_s* root() const;
+        size_t getDepth() const;
+        bool empty() const;
+    };
+
+    class SnapshotHistory
+    {
+    private:
+        std::deque<SharedSnapshot> mSnapshots;
+        size_t mCapacity;
+
+    public:
+        explicit SnapshotHistory(size_t capacity = 4);
+
+        void push(const SharedSnapshot& snapshot);
+        void clear();
+
+        const SharedSnapshot* latest() const;
+        const SharedSnapshot* at(size_t age) const;
+        size_t size() const;
+    };
+}
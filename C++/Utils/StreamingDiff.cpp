@@ -0,0 +1,429 @@
+#include "StreamingDiff.h"
+#include "utils/KeyTable.h"
+#include <string.h>
+
+namespace Utils
+{
+    StreamingDiffHandler::StreamingDiffHandler(const input_value* snapshot,
+        input_value* outDiffModify, input_value::AllocatorType* allocatorModify,
+        input_value* outDiffDelete, input_value::AllocatorType* allocatorDelete) :
+        mSnapshot(snapshot),
+        mOutDiffModify(outDiffModify),
+        mAllocatorModify(allocatorModify),
+        mOutDiffDelete(outDiffDelete),
+        mAllocatorDelete(allocatorDelete)
+    {
+    }
+
+    void StreamingDiffHandler::setSnapshotIndex(const MemberIndex* snapshotIndex)
+    {
+        mSnapshotIndex = snapshotIndex;
+    }
+
+    void StreamingDiffHandler::setArrayDiff(const ArrayDiff::Options_s* arrayDiff)
+    {
+        mArrayDiff = arrayDiff;
+    }
+
+    void StreamingDiffHandler::setBudget(OutputBudget* budget)
+    {
+        mMeter.attach(budget, mAllocatorModify, mAllocatorDelete);
+    }
+
+    bool StreamingDiffHandler::isComplete() const
+    {
+        return mComplete;
+    }
+
+    const DiffCounters_s& StreamingDiffHandler::getCounters() const
+    {
+        return mCounters;
+    }
+
+    void StreamingDiffHandler::pushPath(const char* name, size_t length)
+    {
+        if (mPathSize == mPath.size())
+        {
+            mPath.emplace_back();
+        }
+
+        mPath[mPathSize++].assign(name, length);
+    }
+
+    input_value* StreamingDiffHandler::materializePath(input_value* outDiff, input_value::AllocatorType& allocator) const
+    {
+        auto& keyTable = KeyTable::instance();
+        auto current = outDiff;
+
+        for (size_t i = 0; i < mPathSize; i++)
+        {
+            const auto& key = mPath[i];
+
+            if (!current->IsObject())
+            {
+                current->SetObject();
+            }
+
+            auto currentMember = current->FindMember(key.c_str());
+
+            if (currentMember == current->MemberEnd())
+            {
+                const auto keyId = keyTable.intern(key.c_str(), key.size());
+                input_value name;
+                input_value newNode(rapidjson::kObjectType);
+
+                if (keyId != KeyTable::kInvalidId)
+                {
+                    const auto& interned = keyTable.getName(keyId);
+                    name.SetString(rapidjson::StringRef(interned.c_str(), interned.size()));
+                }
+                else
+                {
+                    name.SetString(key.c_str(), static_cast<rapidjson::SizeType>(key.size()), allocator);
+                }
+
+                current->AddMember(name, newNode, allocator);
+                current = &(current->MemberEnd() - 1)->value;
+            }
+            else
+            {
+                current = &currentMember->value;
+            }
+        }
+
+        return current;
+    }
+
+    void StreamingDiffHandler::writeModify(const input_value& value)
+    {
+        auto target = materializePath(mOutDiffModify, *mAllocatorModify);
+
+        if (value.IsString())
+        {
+            target->SetString(value.GetString(), value.GetStringLength(), *mAllocatorModify);
+        }
+        else
+        {
+            target->CopyFrom(value, *mAllocatorModify);
+        }
+    }
+
+    void StreamingDiffHandler::writeDelete(const char* name)
+    {
+        pushPath(name, strlen(name));
+        materializePath(mOutDiffDelete, *mAllocatorDelete)->SetInt(0);
+        mPathSize--;
+    }
+
+    void StreamingDiffHandler::writeDeletedMembers(const input_value& prev, const std::vector<uint8_t>* seen)
+    {
+        rapidjson::SizeType index = 0;
+
+        for (auto m = prev.MemberBegin(); m != prev.MemberEnd(); ++m, ++index)
+        {
+            if (seen == nullptr || !(*seen)[index])
+            {
+                writeDelete(m->name.GetString());
+            }
+        }
+    }
+
+    void StreamingDiffHandler::completeMember()
+    {
+        if (!mFrames.empty())
+        {
+            mPathSize--;
+        }
+
+        mPendingPrev = nullptr;
+    }
+
+    bool StreamingDiffHandler::onLeaf(const input_value& curr)
+    {
+        if (mFrames.empty())
+        {
+            return false;
+        }
+
+        const auto prev = mPendingPrev;
+
+        if (prev != nullptr && prev->IsObject())
+        {
+            writeDeletedMembers(*prev, nullptr);
+        }
+
+        if (prev == nullptr || curr != *prev)
+        {
+            input_value patch;
+
+            if (mArrayDiff != nullptr && prev != nullptr &&
+                ArrayDiff::build(curr, *prev, *mArrayDiff, patch, *mAllocatorModify))
+            {
+                *materializePath(mOutDiffModify, *mAllocatorModify) = patch;
+            }
+            else
+            {
+                writeModify(curr);
+            }
+        }
+
+        completeMember();
+        return mMeter.update();
+    }
+
+    bool StreamingDiffHandler::onValue(input_value& value)
+    {
+        if (mCaptureStack.empty())
+        {
+            return onLeaf(value);
+        }
+
+        auto& container = mCaptureStack.back();
+
+        if (container.IsArray())
+        {
+            container.PushBack(value, mCaptureAllocator);
+        }
+        else
+        {
+            if (mCaptureKeys.empty())
+            {
+                return false;
+            }
+
+            container.AddMember(mCaptureKeys.back(), value, mCaptureAllocator);
+            mCaptureKeys.pop_back();
+        }
+
+        return true;
+    }
+
+    bool StreamingDiffHandler::Null()
+    {
+        input_value value;
+        return onValue(value);
+    }
+
+    bool StreamingDiffHandler::Bool(bool value)
+    {
+        input_value item;
+        item.SetBool(value);
+        return onValue(item);
+    }
+
+    bool StreamingDiffHandler::Int(int value)
+    {
+        input_value item;
+        item.SetInt(value);
+        return onValue(item);
+    }
+
+    bool StreamingDiffHandler::Uint(unsigned value)
+    {
+        input_value item;
+        item.SetUint(value);
+        return onValue(item);
+    }
+
+    bool StreamingDiffHandler::Int64(int64_t value)
+    {
+        input_value item;
+        item.SetInt64(value);
+        return onValue(item);
+    }
+
+    bool StreamingDiffHandler::Uint64(uint64_t value)
+    {
+        input_value item;
+        item.SetUint64(value);
+        return onValue(item);
+    }
+
+    bool StreamingDiffHandler::Double(double value)
+    {
+        input_value item;
+        item.SetDouble(value);
+        return onValue(item);
+    }
+
+    bool StreamingDiffHandler::String(const char* str, rapidjson::SizeType length, bool copy)
+    {
+        input_value item;
+
+        if (mCaptureStack.empty())
+        {
+            item.SetString(rapidjson::StringRef(str, length));
+        }
+        else
+        {
+            item.SetString(str, length, mCaptureAllocator);
+        }
+
+        return onValue(item);
+    }
+
+    bool StreamingDiffHandler::StartObject()
+    {
+        if (!mCaptureStack.empty())
+        {
+            mCaptureStack.emplace_back(rapidjson::kObjectType);
+            return true;
+        }
+
+        const input_value* prev = nullptr;
+
+        if (mFrames.empty())
+        {
+            if (mComplete)
+            {
+                return false;
+            }
+
+            prev = mSnapshot;
+        }
+        else
+        {
+            prev = mPendingPrev;
+        }
+
+        Frame_s frame{ prev != nullptr && prev->IsObject() ? prev : nullptr, std::vector<uint8_t>(), 0 };
+
+        if (frame.prev != nullptr)
+        {
+            frame.seen.resize(frame.prev->MemberCount(), 0);
+        }
+
+        mFrames.push_back(std::move(frame));
+        return true;
+    }
+
+    bool StreamingDiffHandler::Key(const char* str, rapidjson::SizeType length, bool copy)
+    {
+        if (!mCaptureStack.empty())
+        {
+            mCaptureKeys.emplace_back(str, length, mCaptureAllocator);
+            return true;
+        }
+
+        if (mFrames.empty() || mMeter.isExceeded())
+        {
+            return false;
+        }
+
+        auto& frame = mFrames.back();
+        mCounters.nodesVisited++;
+        pushPath(str, length);
+        frame.memberCount++;
+        mPendingPrev = nullptr;
+
+        if (frame.prev != nullptr)
+        {
+            const auto& name = mPath[mPathSize - 1];
+            const input_value::Member* member = nullptr;
+
+            if (mSnapshotIndex != nullptr)
+            {
+                member = mSnapshotIndex->find(*frame.prev, name.c_str());
+            }
+            else
+            {
+                auto found = frame.prev->FindMember(name.c_str());
+                member = found != frame.prev->MemberEnd() ? &*found : nullptr;
+            }
+
+            if (member != nullptr)
+            {
+                frame.seen[member - &*frame.prev->MemberBegin()] = 1;
+                mPendingPrev = &member->value;
+            }
+        }
+
+        return true;
+    }
+
+    bool StreamingDiffHandler::EndObject(rapidjson::SizeType memberCount)
+    {
+        if (!mCaptureStack.empty())
+        {
+            input_value value;
+            value = mCaptureStack.back();
+            mCaptureStack.pop_back();
+
+            if (mCaptureStack.empty())
+            {
+                return false;
+            }
+
+            return onValue(value);
+        }
+
+        if (mFrames.empty())
+        {
+            return false;
+        }
+
+        auto& frame = mFrames.back();
+
+        if (frame.prev != nullptr)
+        {
+            writeDeletedMembers(*frame.prev, &frame.seen);
+        }
+        else if (frame.memberCount == 0 && mFrames.size() > 1)
+        {
+            input_value emptyObject(rapidjson::kObjectType);
+            writeModify(emptyObject);
+        }
+
+        mFrames.pop_back();
+
+        if (!mMeter.update())
+        {
+            return false;
+        }
+
+        if (mFrames.empty())
+        {
+            mComplete = true;
+        }
+        else
+        {
+            completeMember();
+        }
+
+        return true;
+    }
+
+    bool StreamingDiffHandler::StartArray()
+    {
+        if (mCaptureStack.empty() && mFrames.empty())
+        {
+            return false;
+        }
+
+        mCaptureStack.emplace_back(rapidjson::kArrayType);
+        return true;
+    }
+
+    bool StreamingDiffHandler::EndArray(rapidjson::SizeType elementCount)
+    {
+        if (mCaptureStack.empty())
+        {
+            return false;
+        }
+
+        input_value value;
+        value = mCaptureStack.back();
+        mCaptureStack.pop_back();
+
+        if (!mCaptureStack.empty())
+        {
+            return onValue(value);
+        }
+
+        const auto result = onLeaf(value);
+        value.SetNull();
+        mCaptureKeys.clear();
+        mCaptureAllocator.Clear();
+        return result;
+    }
+}
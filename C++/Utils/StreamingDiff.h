@@ -0,0 +1,89 @@
+#pragma once
+
+#include "data/static.h"
+#include "utils/ArrayDiff.h"
+#include "utils/MemberIndex.h"
+#include "utils/OutputBudget.h"
+#include "utils/DiffMetrics.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace Utils
+{
+    class StreamingDiffHandler
+    {
+    private:
+        struct Frame_s
+        {
+            const input_value* prev;
+            std::vector<uint8_t> seen;
+            size_t memberCount;
+        };
+
+        const input_value* mSnapshot;
+        input_value* mOutDiffModify;
+        input_value::AllocatorType* mAllocatorModify;
+        input_value* mOutDiffDelete;
+        input_value::AllocatorType* mAllocatorDelete;
+        const MemberIndex* mSnapshotIndex = nullptr;
+        const ArrayDiff::Options_s* mArrayDiff = nullptr;
+        OutputMeter mMeter;
+        DiffCounters_s mCounters;
+
+        std::vector<Frame_s> mFrames;
+        // Names are kept here rather than interned, so streaming arbitrary keys does not
+        // grow the shared KeyTable; strings are reused across pushes.
+        std::vector<std::string> mPath;
+        size_t mPathSize = 0;
+        const input_value* mPendingPrev = nullptr;
+        bool mComplete = false;
+
+        input_value::AllocatorType mCaptureAllocator;
+        std::vector<input_value> mCaptureStack;
+        std::vector<input_value> mCaptureKeys;
+
+        void pushPath(const char* name, size_t length);
+        input_value* materializePath(input_value* outDiff, input_value::AllocatorType& allocator) const;
+        void writeModify(const input_value& value);
+        void writeDelete(const char* name);
+        void writeDeletedMembers(const input_value& prev, const std::vector<uint8_t>* seen);
+
+        bool onValue(input_value& value);
+        bool onLeaf(const input_value& curr);
+        void completeMember();
+
+    public:
+        StreamingDiffHandler(const input_value* snapshot,
+            input_value* outDiffModify, input_value::AllocatorType* allocatorModify,
+            input_value* outDiffDelete, input_value::AllocatorType* allocatorDelete);
+
+        void setSnapshotIndex(const MemberIndex* snapshotIndex);
+        void setArrayDiff(const ArrayDiff::Options_s* arrayDiff);
+        void setBudget(OutputBudget* budget);
+        bool isComplete() const;
+        const DiffCounters_s& getCounters() const;
+
+        bool Null();
+        bool Bool(bool value);
+        bool Int(int value);
+        bool Uint(unsigned value);
+        bool Int64(int64_t value);
+        bool Uint64(uint64_t value);
+        bool Double(double value);
+        bool String(const char* str, rapidjson::SizeType length, bool copy);
+        bool StartObject();
+        bool Key(const char* str, rapidjson::SizeType length, bool copy);
+        bool EndObject(rapidjson::SizeType memberCount);
+        bool StartArray();
+        bool EndArray(rapidjson::SizeType elementCount);
+    };
+
+    class IStreamingSource
+    {
+    public:
+        virtual bool save(StreamingDiffHandler& handler) = 0;
+
+        virtual ~IStreamingSource() = default;
+    };
+}
@@ -0,0 +1,141 @@
+#include "SubtreeHash.h"
+#include <string.h>
+
+namespace Utils
+{
+    namespace
+    {
+        inline uint64_t mix(uint64_t value)
+        {
+            value += 0x9e3779b97f4a7c15ULL;
+            value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+            return value ^ (value >> 31);
+        }
+
+        inline uint64_t combine(uint64_t seed, uint64_t value)
+        {
+            return mix(seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+        }
+
+        inline uint64_t hashString(const char* str, size_t length)
+        {
+            auto hash = 0xcbf29ce484222325ULL;
+
+            for (size_t i = 0; i < length; i++)
+            {
+                hash ^= static_cast<unsigned char>(str[i]);
+                hash *= 0x100000001b3ULL;
+            }
+
+            return mix(hash ^ length);
+        }
+    }
+
+    uint64_t SubtreeHash::hashValue(const input_value& value, std::unordered_map<const input_value*, uint64_t>* hashes)
+    {
+        switch (value.GetType())
+        {
+        case rapidjson::kObjectType:
+        {
+            auto hash = mix(rapidjson::kObjectType);
+
+            for (auto m = value.MemberBegin(); m != value.MemberEnd(); ++m)
+            {
+                const auto keyHash = hashString(m->name.GetString(), m->name.GetStringLength());
+                hash += combine(keyHash, hashValue(m->value, hashes));
+            }
+
+            hash = combine(hash, value.MemberCount());
+
+            if (hashes != nullptr)
+            {
+                (*hashes)[&value] = hash;
+            }
+
+            return hash;
+        }
+        case rapidjson::kArrayType:
+        {
+            auto hash = mix(rapidjson::kArrayType);
+
+            for (auto v = value.Begin(); v != value.End(); ++v)
+            {
+                hash = combine(hash, hashValue(*v, hashes));
+            }
+
+            return combine(hash, value.Size());
+        }
+        case rapidjson::kStringType:
+        {
+            return combine(rapidjson::kStringType, hashString(value.GetString(), value.GetStringLength()));
+        }
+        case rapidjson::kNumberType:
+        {
+            if (value.IsDouble())
+            {
+                const auto number = value.GetDouble();
+                uint64_t bits = 0;
+                memcpy(&bits, &number, sizeof(bits));
+                return combine(rapidjson::kNumberType, bits);
+            }
+
+            return combine(rapidjson::kNumberType, value.IsInt64() ? static_cast<uint64_t>(value.GetInt64()) : value.GetUint64());
+        }
+        default:
+        {
+            return mix(value.GetType());
+        }
+        }
+    }
+
+    void SubtreeHash::build(const input_value& root)
+    {
+        mHashes.clear();
+        hashValue(root, &mHashes);
+    }
+
+    void SubtreeHash::clear()
+    {
+        mHashes.clear();
+    }
+
+    bool SubtreeHash::find(const input_value& node, uint64_t& outHash) const
+    {
+        const auto it = mHashes.find(&node);
+
+        if (it == mHashes.end())
+        {
+            return false;
+        }
+
+        outHash = it->second;
+        return true;
+    }
+
+    size_t SubtreeHash::size() const
+    {
+        return mHashes.size();
+    }
+
+    uint64_t SubtreeHash::compute(const input_value& value)
+    {
+        return hashValue(value, nullptr);
+    }
+
+    bool SubtreeHash::isSame(const SubtreeHash* sourceHashes, const input_value& source,
+        const SubtreeHash* targetHashes, const input_value* target)
+    {
+        if (sourceHashes == nullptr || targetHashes == nullptr || target == nullptr)
+        {
+            return false;
+        }
+
+        uint64_t sourceHash = 0;
+        uint64_t targetHash = 0;
+
+        return sourceHashes->find(source, sourceHash) &&
+            targetHashes->find(*target, targetHash) &&
+            sourceHash == targetHash;
+    }
+}
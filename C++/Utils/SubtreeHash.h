@@ -0,0 +1,30 @@
+#pragma once
+
+#include "data/static.h"
+#include <stdint.h>
+#include <unordered_map>
+
+namespace Utils
+{
+    class SubtreeHash
+    {
+    private:
+        std::unordered_map<const input_value*, uint64_t> mHashes;
+
+        static uint64_t hashValue(const input_value& value, std::unordered_map<const input_value*, uint64_t>* hashes);
+
+    public:
+        SubtreeHash() = default;
+
+        void build(const input_value& root);
+        void clear();
+
+        bool find(const input_value& node, uint64_t& outHash) const;
+        size_t size() const;
+
+        static uint64_t compute(const input_value& value);
+
+        static bool isSame(const SubtreeHash* sourceHashes, const input_value& source,
+            const SubtreeHash* targetHashes, const input_value* target);
+    };
+}
@@ -0,0 +1,207 @@
+#include "SyntheticDocument.h"
+
+namespace Utils
+{
+    SyntheticDocument::SyntheticDocument(const Options_s& options) :
+        mOptions(options),
+        mRandom(options.seed)
+    {
+    }
+
+    const SyntheticDocument::Options_s& SyntheticDocument::getOptions() const
+    {
+        return mOptions;
+    }
+
+    double SyntheticDocument::nextRatio()
+    {
+        return std::uniform_real_distribution<double>(0.0, 1.0)(mRandom);
+    }
+
+    void SyntheticDocument::generateString(input_value& out, input_value::AllocatorType& allocator)
+    {
+        std::string value(mOptions.stringLength, 'a');
+
+        for (auto& c : value)
+        {
+            c = static_cast<char>('a' + mRandom() % 26);
+        }
+
+        out.SetString(value.c_str(), static_cast<rapidjson::SizeType>(value.size()), allocator);
+    }
+
+    void SyntheticDocument::generateScalar(input_value& out, input_value::AllocatorType& allocator)
+    {
+        switch (mRandom() % 4)
+        {
+        case 0:
+            out.SetInt(static_cast<int>(mRandom() % 100000));
+            break;
+        case 1:
+            out.SetDouble(static_cast<double>(mRandom() % 100000) / 100.0);
+            break;
+        case 2:
+            out.SetBool(mRandom() % 2 == 0);
+            break;
+        default:
+            generateString(out, allocator);
+            break;
+        }
+    }
+
+    void SyntheticDocument::generateArray(input_value& out, input_value::AllocatorType& allocator)
+    {
+        out.SetArray();
+        const auto ofObjects = mRandom() % 2 == 0;
+
+        for (size_t i = 0; i < mOptions.arrayLength; i++)
+        {
+            input_value element;
+
+            if (ofObjects)
+            {
+                element.SetObject();
+                input_value id(static_cast<int>(mNextKey++));
+                input_value count(static_cast<int>(mRandom() % 100));
+                element.AddMember(rapidjson::StringRef("id"), id, allocator);
+                element.AddMember(rapidjson::StringRef("count"), count, allocator);
+            }
+            else
+            {
+                element.SetInt(static_cast<int>(mRandom() % 1000));
+            }
+
+            out.PushBack(element, allocator);
+        }
+    }
+
+    void SyntheticDocument::generateValue(input_value& out, input_value::AllocatorType& allocator, size_t depth)
+    {
+        const auto ratio = nextRatio();
+
+        if (depth > 0 && ratio < mOptions.objectRatio)
+        {
+            generateObject(out, allocator, depth - 1);
+        }
+        else if (ratio < mOptions.objectRatio + mOptions.arrayRatio)
+        {
+            generateArray(out, allocator);
+        }
+        else
+        {
+            generateScalar(out, allocator);
+        }
+    }
+
+    void SyntheticDocument::generateObject(input_value& out, input_value::AllocatorType& allocator, size_t depth)
+    {
+        out.SetObject();
+
+        for (size_t i = 0; i < mOptions.width; i++)
+        {
+            const auto key = "f" + std::to_string(mNextKey++);
+            input_value name(key.c_str(), static_cast<rapidjson::SizeType>(key.size()), allocator);
+            input_value value;
+            generateValue(value, allocator, depth);
+            out.AddMember(name, value, allocator);
+        }
+    }
+
+    void SyntheticDocument::generate(input_value& out, input_value::AllocatorType& allocator)
+    {
+        generateObject(out, allocator, mOptions.depth);
+    }
+
+    void SyntheticDocument::markDirty(DirtyPathTracker* dirtyPaths, const char* name)
+    {
+        if (dirtyPaths == nullptr)
+        {
+            return;
+        }
+
+        mPath.push_back(name);
+        dirtyPaths->markDirty(mPath.data(), mPath.size());
+        mPath.pop_back();
+    }
+
+    void SyntheticDocument::changeValue(input_value& value, input_value::AllocatorType& allocator)
+    {
+        if (value.IsArray() && !value.Empty())
+        {
+            auto& element = value[static_cast<rapidjson::SizeType>(mRandom() % value.Size())];
+
+            if (element.IsObject())
+            {
+                auto member = element.FindMember("count");
+
+                if (member != element.MemberEnd())
+                {
+                    member->value.SetInt(static_cast<int>(mRandom() % 100));
+                    return;
+                }
+            }
+
+            element.SetInt(static_cast<int>(mRandom() % 1000));
+            return;
+        }
+
+        generateScalar(value, allocator);
+    }
+
+    size_t SyntheticDocument::mutateObject(input_value& object, input_value::AllocatorType& allocator, size_t depth, DirtyPathTracker* dirtyPaths)
+    {
+        size_t changes = 0;
+
+        for (auto m = object.MemberBegin(); m != object.MemberEnd();)
+        {
+            const auto ratio = nextRatio();
+
+            if (ratio < mOptions.deleteRatio)
+            {
+                markDirty(dirtyPaths, m->name.GetString());
+                m = object.EraseMember(m);
+                changes++;
+                continue;
+            }
+
+            if (m->value.IsObject())
+            {
+                mPath.push_back(m->name.GetString());
+                changes += mutateObject(m->value, allocator, depth > 0 ? depth - 1 : 0, dirtyPaths);
+                mPath.pop_back();
+            }
+            else if (ratio < mOptions.deleteRatio + mOptions.changeRatio)
+            {
+                markDirty(dirtyPaths, m->name.GetString());
+                changeValue(m->value, allocator);
+                changes++;
+            }
+
+            ++m;
+        }
+
+        if (nextRatio() < mOptions.insertRatio * mOptions.width)
+        {
+            const auto key = "n" + std::to_string(mNextKey++);
+            input_value name(key.c_str(), static_cast<rapidjson::SizeType>(key.size()), allocator);
+            input_value value;
+            generateValue(value, allocator, depth);
+            markDirty(dirtyPaths, key.c_str());
+            object.AddMember(name, value, allocator);
+            changes++;
+        }
+
+        return changes;
+    }
+
+    size_t SyntheticDocument::mutate(input_value& document, input_value::AllocatorType& allocator, DirtyPathTracker* dirtyPaths)
+    {
+        if (!document.IsObject())
+        {
+            return 0;
+        }
+
+        mPath.clear();
+        return mutateObject(document, allocator, mOptions.depth, dirtyPaths);
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "utils/DirtyPathTracker.h"
+#include "data/static.h"
+#include <random>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace Utils
+{
+    class SyntheticDocument
+    {
+    public:
+        struct Options_s
+        {
+            size_t depth = 3;
+            size_t width = 8;
+            size_t arrayLength = 16;
+            size_t stringLength = 12;
+            double objectRatio = 0.3;
+            double arrayRatio = 0.1;
+            double changeRatio = 0.05;
+            double deleteRatio = 0.01;
+            double insertRatio = 0.01;
+            uint32_t seed = 1;
+        };
+
+    private:
+        Options_s mOptions;
+        std::mt19937 mRandom;
+        std::vector<const char*> mPath;
+        size_t mNextKey = 0;
+
+        double nextRatio();
+        void generateObject(input_value& out, input_value::AllocatorType& allocator, size_t depth);
+        void generateArray(input_value& out, input_value::AllocatorType& allocator);
+        void generateScalar(input_value& out, input_value::AllocatorType& allocator);
+        void generateString(input_value& out, input_value::AllocatorType& allocator);
+        void generateValue(input_value& out, input_value::AllocatorType& allocator, size_t depth);
+        void changeValue(input_value& value, input_value::AllocatorType& allocator);
+        size_t mutateObject(input_value& object, input_value::AllocatorType& allocator, size_t depth, DirtyPathTracker* dirtyPaths);
+        void markDirty(DirtyPathTracker* dirtyPaths, const char* name);
+
+    public:
+        explicit SyntheticDocument(const Options_s& options);
+
+        void generate(input_value& out, input_value::AllocatorType& allocator);
+        size_t mutate(input_value& document, input_value::AllocatorType& allocator, DirtyPathTracker* dirtyPaths = nullptr);
+
+        const Options_s& getOptions() const;
+    };
+}
@@ -0,0 +1,106 @@
+#include "TaskExecutor.h"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+namespace Utils
+{
+    namespace
+    {
+        struct ParallelForState_s
+        {
+            std::atomic<size_t> next;
+            size_t count;
+            std::function<void(size_t)> body;
+            std::mutex mutex;
+            std::condition_variable finished;
+            size_t activeHelpers = 0;
+            bool closed = false;
+            std::exception_ptr error;
+
+            void run()
+            {
+                try
+                {
+                    for (auto index = next++; index < count; index = next++)
+                    {
+                        body(index);
+                    }
+                }
+                catch (...)
+                {
+                    next = count;
+
+                    std::lock_guard<std::mutex> lock(mutex);
+
+                    if (!error)
+                    {
+                        error = std::current_exception();
+                    }
+                }
+            }
+        };
+    }
+
+    void parallelFor(ITaskExecutor& executor, size_t count, const std::function<void(size_t)>& body)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        if (count == 1 || executor.getConcurrency() == 0)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                body(i);
+            }
+
+            return;
+        }
+
+        auto state = std::make_shared<ParallelForState_s>();
+        state->next = 0;
+        state->count = count;
+        state->body = body;
+
+        const auto helpers = std::min(count - 1, executor.getConcurrency());
+
+        for (size_t i = 0; i < helpers; i++)
+        {
+            executor.execute([state]()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+
+                    if (state->closed)
+                    {
+                        return;
+                    }
+
+                    state->activeHelpers++;
+                }
+
+                state->run();
+
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->activeHelpers--;
+                state->finished.notify_all();
+            });
+        }
+
+        state->run();
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->closed = true;
+        state->finished.wait(lock, [&state]() { return state->activeHelpers == 0; });
+
+        if (state->error)
+        {
+            std::rethrow_exception(state->error);
+        }
+    }
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <functional>
+#include <stddef.h>
+
+namespace Utils
+{
+    class ITaskExecutor
+    {
+    public:
+        typedef std::function<void()> Task_t;
+
+        virtual void execute(Task_t task) = 0;
+        virtual size_t getConcurrency() const = 0;
+
+        virtual ~ITaskExecutor() = default;
+    };
+
+    // Returns once every index has run. If body throws, no further indices are handed out,
+    // all running helpers are joined and the first exception is rethrown to the caller.
+    void parallelFor(ITaskExecutor& executor, size_t count, const std::function<void(size_t)>& body);
+}
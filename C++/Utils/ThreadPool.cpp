@@ -0,0 +1,79 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace Utils
+{
+    ThreadPool::ThreadPool(size_t threadCount)
+    {
+        if (threadCount == 0)
+        {
+            threadCount = std::max(1U, std::thread::hardware_concurrency());
+        }
+
+        mWorkers.reserve(threadCount);
+
+        for (size_t i = 0; i < threadCount; i++)
+        {
+            mWorkers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mStopping = true;
+        }
+
+        mTaskAvailable.notify_all();
+
+        for (auto& worker : mWorkers)
+        {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::workerLoop()
+    {
+        while (true)
+        {
+            Task_t task;
+
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mTaskAvailable.wait(lock, [this]() { return mStopping || !mTasks.empty(); });
+
+                if (mTasks.empty())
+                {
+                    return;
+                }
+
+                task = std::move(mTasks.front());
+                mTasks.pop_front();
+            }
+
+            task();
+        }
+    }
+
+    void ThreadPool::execute(Task_t task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mTasks.push_back(std::move(task));
+        }
+
+        mTaskAvailable.notify_one();
+    }
+
+    size_t ThreadPool::getConcurrency() const
+    {
+        return mWorkers.size();
+    }
+
+    ThreadPool& ThreadPool::shared()
+    {
+        static ThreadPool sharedPool;
+        return sharedPool;
+    }
+}
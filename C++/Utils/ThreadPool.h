@@ -0,0 +1,35 @@
+#pragma once
+
+#include "utils/TaskExecutor.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Utils
+{
+    class ThreadPool : public ITaskExecutor
+    {
+    private:
+        std::vector<std::thread> mWorkers;
+        std::deque<Task_t> mTasks;
+        std::mutex mMutex;
+        std::condition_variable mTaskAvailable;
+        bool mStopping = false;
+
+        ThreadPool(const ThreadPool& source) = delete;
+        void operator=(const ThreadPool& source) = delete;
+
+        void workerLoop();
+
+    public:
+        explicit ThreadPool(size_t threadCount = 0);
+        ~ThreadPool();
+
+        void execute(Task_t task) override;
+        size_t getConcurrency() const override;
+
+        static ThreadPool& shared();
+    };
+}